@@ -0,0 +1,301 @@
+//------------------------------------------------------------------------------
+// Sprite stress benchmark.
+//
+// Spawns a configurable number of ship/diamond sprites with random motion,
+// renders a fixed number of frames into a hidden window and prints a JSON
+// report with frame time percentiles, draw calls, state changes, bytes
+// uploaded and peak RSS.
+//
+// Example:
+//		./453-bench --sprites=100000 --frames=600 --output=report.json
+//
+// Run with LIBGL_ALWAYS_SOFTWARE=1 (Mesa) to force the llvmpipe rasterizer,
+// e.g. on machines without a GPU. The renderer used is part of the report.
+//------------------------------------------------------------------------------
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "FastMath.h"
+#include "FlightRecorder.h"
+#include "GLHandles.h"
+#include "GLState.h"
+#include "Log.h"
+#include "RenderStats.h"
+#include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "Texture.h"
+#include "Window.h"
+
+#include "imgui/imgui.h"
+#include "imgui/imgui_impl_glfw.h"
+#include "imgui/imgui_impl_opengl3.h"
+
+#include <argh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+
+namespace {
+
+	struct BenchConfig {
+		size_t sprites = 10000;
+		int frames = 600;
+		int warmup = 60;
+		unsigned int seed = 453;
+		int width = 800;
+		int height = 800;
+		int shipEvery = 8; // one in every shipEvery sprites is a ship
+		std::string output;
+	};
+
+	// Sprites move in straight lines and bounce off the edges of the screen.
+	// Kept as separate arrays since that is what the update loop streams over.
+	struct Sprites {
+		std::vector<float> x, y, vx, vy, theta, spin, scale;
+		std::vector<float> sinTheta, cosTheta;
+
+		void spawn(size_t count, unsigned int seed) {
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+			std::uniform_real_distribution<float> velocity(-0.5f, 0.5f);
+			std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+			std::uniform_real_distribution<float> angular(-3.0f, 3.0f);
+
+			for (std::vector<float>* v : { &x, &y, &vx, &vy, &theta, &spin, &scale, &sinTheta, &cosTheta }) {
+				v->resize(count);
+			}
+			// Shrink sprites as the scene grows so large scenes still show
+			// individual sprites instead of a solid wall of overdraw.
+			float size = std::max(0.002f, 0.125f / std::sqrt(static_cast<float>(count) / 16.0f + 1.0f));
+			for (size_t i = 0; i < count; i++) {
+				x[i] = position(rng);
+				y[i] = position(rng);
+				vx[i] = velocity(rng);
+				vy[i] = velocity(rng);
+				theta[i] = angle(rng);
+				spin[i] = angular(rng);
+				scale[i] = size;
+			}
+		}
+
+		void update(float dt) {
+			size_t n = x.size();
+			for (size_t i = 0; i < n; i++) {
+				x[i] += vx[i] * dt;
+				y[i] += vy[i] * dt;
+				theta[i] += spin[i] * dt;
+				if (x[i] < -1.0f || x[i] > 1.0f) vx[i] = -vx[i];
+				if (y[i] < -1.0f || y[i] > 1.0f) vy[i] = -vy[i];
+			}
+			fastSinCos(theta.data(), sinTheta.data(), cosTheta.data(), n);
+		}
+	};
+
+	double percentile(const std::vector<double>& sorted, double p) {
+		if (sorted.empty()) return 0.0;
+		double rank = p * static_cast<double>(sorted.size() - 1);
+		size_t lo = static_cast<size_t>(rank);
+		size_t hi = std::min(lo + 1, sorted.size() - 1);
+		double t = rank - static_cast<double>(lo);
+		return sorted[lo] * (1.0 - t) + sorted[hi] * t;
+	}
+
+	uint64_t peakResidentBytes() {
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+		}
+		return 0;
+#else
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+		return static_cast<uint64_t>(usage.ru_maxrss);         // bytes
+#else
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+#endif
+	}
+
+	std::string glString(GLenum name) {
+		const GLubyte* str = glGetString(name);
+		return str ? reinterpret_cast<const char*>(str) : "unknown";
+	}
+
+	std::string jsonEscape(const std::string& str) {
+		std::string out;
+		for (char c : str) {
+			if (c == '"' || c == '\\') out += '\\';
+			out += c;
+		}
+		return out;
+	}
+}
+
+
+int main(int argc, char* argv[]) {
+	argh::parser cmdl(argc, argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+
+	BenchConfig config;
+	cmdl("sprites", config.sprites) >> config.sprites;
+	cmdl("frames", config.frames) >> config.frames;
+	cmdl("warmup", config.warmup) >> config.warmup;
+	cmdl("seed", config.seed) >> config.seed;
+	cmdl("width", config.width) >> config.width;
+	cmdl("height", config.height) >> config.height;
+	cmdl("ship-every", config.shipEvery) >> config.shipEvery;
+	cmdl("output", config.output) >> config.output;
+
+	config.sprites = std::clamp<size_t>(config.sprites, 1, 1000000);
+	config.shipEvery = std::max(config.shipEvery, 1);
+
+	// WINDOW
+	// The benchmark renders into a hidden window, so nothing has to be
+	// composited and vsync does not cap the frame rate.
+	glfwInit();
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	Window window(config.width, config.height, "453-bench");
+	glfwSwapInterval(0);
+
+	// The flight recorder would dump traces for the intentionally slow
+	// warmup frames; this run is measured separately.
+	FlightRecorder::get().setEnabled(false);
+
+	ShaderProgram shader("shaders/sprite.vert", "shaders/test.frag");
+	Texture shipTexture("textures/ship.png", GL_NEAREST);
+	Texture diamondTexture("textures/diamond.png", GL_NEAREST);
+
+	SpriteBatch ships;
+	SpriteBatch diamonds;
+
+	Sprites sprites;
+	sprites.spawn(config.sprites, config.seed);
+
+	std::vector<SpriteInstance> shipInstances;
+	std::vector<SpriteInstance> diamondInstances;
+	shipInstances.reserve(config.sprites / config.shipEvery + 1);
+	diamondInstances.reserve(config.sprites);
+
+	std::vector<double> frameMs;
+	frameMs.reserve(config.frames);
+	uint64_t totalDrawCalls = 0;
+	uint64_t totalBytesUploaded = 0;
+	uint64_t totalStateChanges = 0;
+
+	// A fixed time step keeps the simulated work identical between runs
+	// no matter how fast the frames are.
+	const float dt = 1.0f / 60.0f;
+
+	for (int frame = 0; frame < config.warmup + config.frames; frame++) {
+		auto start = std::chrono::steady_clock::now();
+		RenderStats::get().reset();
+
+		glfwPollEvents();
+		sprites.update(dt);
+
+		shipInstances.clear();
+		diamondInstances.clear();
+		for (size_t i = 0; i < config.sprites; i++) {
+			glm::vec2 rotation(sprites.cosTheta[i], sprites.sinTheta[i]);
+			SpriteInstance instance = { glm::vec2(sprites.x[i], sprites.y[i]), rotation * sprites.scale[i] };
+			if (i % config.shipEvery == 0) shipInstances.push_back(instance);
+			else diamondInstances.push_back(instance);
+		}
+
+		shader.use();
+		GLState::get().enable(GL_FRAMEBUFFER_SRGB);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		diamonds.setInstances(diamondInstances);
+		diamonds.draw(diamondTexture);
+		ships.setInstances(shipInstances);
+		ships.draw(shipTexture);
+
+		GLState::get().disable(GL_FRAMEBUFFER_SRGB);
+		window.swapBuffers();
+
+		// Without a visible surface the driver may queue frames freely;
+		// wait for the GPU so each sample is the real cost of the frame.
+		glFinish();
+		GLObjectPool::get().collect();
+
+		auto end = std::chrono::steady_clock::now();
+		if (frame >= config.warmup) {
+			frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+			totalDrawCalls += RenderStats::get().drawCalls;
+			totalBytesUploaded += RenderStats::get().bytesUploaded;
+			totalStateChanges += RenderStats::get().stateChanges;
+		}
+	}
+
+	std::vector<double> sorted = frameMs;
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (double ms : frameMs) sum += ms;
+	double frames = static_cast<double>(std::max<size_t>(frameMs.size(), 1));
+
+	std::string report = fmt::format(
+		"{{\n"
+		"  \"benchmark\": \"sprites\",\n"
+		"  \"renderer\": \"{}\",\n"
+		"  \"gl_version\": \"{}\",\n"
+		"  \"sprites\": {},\n"
+		"  \"frames\": {},\n"
+		"  \"warmup\": {},\n"
+		"  \"seed\": {},\n"
+		"  \"resolution\": [{}, {}],\n"
+		"  \"frame_ms\": {{ \"mean\": {:.4f}, \"min\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }},\n"
+		"  \"draw_calls_per_frame\": {:.2f},\n"
+		"  \"state_changes_per_frame\": {:.2f},\n"
+		"  \"bytes_uploaded_per_frame\": {:.0f},\n"
+		"  \"bytes_uploaded_total\": {},\n"
+		"  \"peak_rss_bytes\": {}\n"
+		"}}\n",
+		jsonEscape(glString(GL_RENDERER)), jsonEscape(glString(GL_VERSION)),
+		config.sprites, config.frames, config.warmup, config.seed,
+		config.width, config.height,
+		sum / frames, sorted.empty() ? 0.0 : sorted.front(),
+		percentile(sorted, 0.50), percentile(sorted, 0.90), percentile(sorted, 0.95), percentile(sorted, 0.99),
+		sorted.empty() ? 0.0 : sorted.back(),
+		static_cast<double>(totalDrawCalls) / frames,
+		static_cast<double>(totalStateChanges) / frames,
+		static_cast<double>(totalBytesUploaded) / frames,
+		totalBytesUploaded,
+		peakResidentBytes()
+	);
+
+	if (config.output.empty()) {
+		std::cout << report;
+	}
+	else {
+		std::ofstream out(config.output);
+		out << report;
+		Log::info("BENCH wrote report to {}", config.output);
+	}
+
+	// ImGui cleanup (the Window sets it up)
+	ImGui_ImplOpenGL3_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+
+	glfwTerminate();
+	return 0;
+}
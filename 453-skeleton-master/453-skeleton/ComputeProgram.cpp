@@ -0,0 +1,60 @@
+#include "ComputeProgram.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+
+namespace {
+
+	// GL 4.3 guarantees at least this many work groups along each axis
+	const size_t MAX_GROUPS = 65535;
+}
+
+
+ComputeProgram::ComputeProgram(const std::string& path)
+	: programID()
+	, compute(path, GL_COMPUTE_SHADER)
+{
+	attach(*this, compute);
+	glLinkProgram(programID);
+
+	if (!checkAndLogLinkSuccess()) {
+		throw std::runtime_error("Compute shader did not link.");
+	}
+}
+
+
+void ComputeProgram::dispatch(size_t count, size_t localSize) const {
+	size_t groups = std::min((count + localSize - 1) / localSize, MAX_GROUPS);
+	if (groups == 0) return;
+	glDispatchCompute(static_cast<GLuint>(groups), 1, 1);
+}
+
+
+void attach(ComputeProgram& cp, Shader& s) {
+	glAttachShader(cp.programID, s.shaderID);
+}
+
+
+bool ComputeProgram::checkAndLogLinkSuccess() const {
+
+	GLint success;
+
+	glGetProgramiv(programID, GL_LINK_STATUS, &success);
+	if (!success) {
+		GLint logLength;
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> log(logLength);
+		glGetProgramInfoLog(programID, logLength, NULL, log.data());
+
+		Log::error("COMPUTE_PROGRAM linking {}:\n{}", compute.getPath(), log.data());
+		return false;
+	}
+	else {
+		Log::info("COMPUTE_PROGRAM successfully compiled and linked {}", compute.getPath());
+		return true;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A program made of a single compute shader (GL 4.3).
+//
+// The compute counterpart of ShaderProgram: compiles and links the shader at
+// path on construction and throws std::runtime_error if either step fails.
+// Only construct one once the context is known to support compute shaders,
+// see Window::hasComputeShaders().
+//------------------------------------------------------------------------------
+
+#include "Shader.h"
+
+#include "GLHandles.h"
+#include "GLState.h"
+
+#include <GL/glew.h>
+
+#include <string>
+
+
+class ComputeProgram {
+
+public:
+	explicit ComputeProgram(const std::string& path);
+
+	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+
+	// Public interface
+	void use() const { GLState::get().useProgram(programID); }
+
+	// Runs enough work groups of localSize invocations to cover count
+	// items, one per invocation. Capped at the smallest group count every
+	// implementation supports, so shaders should loop over the items with a
+	// stride of the whole grid rather than assume one pass covers them.
+	void dispatch(size_t count, size_t localSize) const;
+
+	void friend attach(ComputeProgram& cp, Shader& s);
+
+	GLuint getID() const { return programID.value(); }
+
+private:
+	ShaderProgramHandle programID;
+
+	Shader compute;
+
+	bool checkAndLogLinkSuccess() const;
+};
@@ -0,0 +1,170 @@
+#include "CullKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CULL_KERNEL_X86 1
+#include <immintrin.h>
+#else
+#define CULL_KERNEL_X86 0
+#endif
+
+// See OrbitKernel.cpp
+#if CULL_KERNEL_X86 && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+
+namespace {
+
+	// Circles per SIMD block
+	const size_t BLOCK = 8;
+
+	// For every 8 bit visibility mask, the lanes that are set, in order.
+	// Adding the block's first index gives the indices to store.
+	struct CompactTable {
+		alignas(8) uint8_t lanes[256][BLOCK];
+
+		constexpr CompactTable() : lanes() {
+			for (int mask = 0; mask < 256; mask++) {
+				int k = 0;
+				for (int lane = 0; lane < 8; lane++) {
+					if (mask & (1 << lane)) lanes[mask][k++] = static_cast<uint8_t>(lane);
+				}
+			}
+		}
+	};
+
+	constexpr CompactTable COMPACT;
+
+	// Culls [begin, end) one circle at a time, appending to visible from n.
+	// Stores every index and only advances past the visible ones, so there
+	// is no branch per circle.
+	inline size_t cullRange(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t begin, size_t end, uint32_t* visible, size_t n) {
+		for (size_t i = begin; i < end; i++) {
+			float r = radius[i] * radiusScale;
+			bool seen = (r > 0.0f)
+				& (x[i] - r < view.max.x) & (x[i] + r > view.min.x)
+				& (y[i] - r < view.max.y) & (y[i] + r > view.min.y);
+			visible[n] = static_cast<uint32_t>(i);
+			n += seen ? 1 : 0;
+		}
+		return n;
+	}
+
+	using CullCirclesFunction = size_t (*)(const ViewRect&, const float*, const float*, const float*, float, size_t, uint32_t*);
+
+	CullCirclesFunction selectImplementation() {
+		switch (detectSimdLevel()) {
+		case SimdLevel::AVX2: return cullCirclesAVX2;
+		case SimdLevel::SSE2: return cullCirclesSSE2;
+		case SimdLevel::Scalar: return cullCirclesScalar;
+		}
+		return cullCirclesScalar;
+	}
+}
+
+
+size_t cullCircles(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible) {
+	static const CullCirclesFunction implementation = selectImplementation();
+	return implementation(view, x, y, radius, radiusScale, count, visible);
+}
+
+
+size_t cullCirclesScalar(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible) {
+	return cullRange(view, x, y, radius, radiusScale, 0, count, visible, 0);
+}
+
+
+#if CULL_KERNEL_X86
+
+// Every block stores 8 indices at visible + n. Fewer than base circles
+// have been visible so far, so n + 8 <= base + 8 <= count and the stores
+// always stay inside the count the caller made room for.
+
+size_t cullCirclesSSE2(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible) {
+	size_t full = count / BLOCK * BLOCK;
+	size_t n = 0;
+
+	const __m128 minX = _mm_set1_ps(view.min.x);
+	const __m128 minY = _mm_set1_ps(view.min.y);
+	const __m128 maxX = _mm_set1_ps(view.max.x);
+	const __m128 maxY = _mm_set1_ps(view.max.y);
+	const __m128 scale = _mm_set1_ps(radiusScale);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i zeroi = _mm_setzero_si128();
+
+	for (size_t base = 0; base < full; base += BLOCK) {
+		// 8 circles, 4 per register
+		int mask = 0;
+		for (int k = 0; k < 2; k++) {
+			__m128 px = _mm_loadu_ps(x + base + 4 * k);
+			__m128 py = _mm_loadu_ps(y + base + 4 * k);
+			__m128 r = _mm_mul_ps(_mm_loadu_ps(radius + base + 4 * k), scale);
+
+			__m128 seen = _mm_cmpgt_ps(r, zero);
+			seen = _mm_and_ps(seen, _mm_cmplt_ps(_mm_sub_ps(px, r), maxX));
+			seen = _mm_and_ps(seen, _mm_cmpgt_ps(_mm_add_ps(px, r), minX));
+			seen = _mm_and_ps(seen, _mm_cmplt_ps(_mm_sub_ps(py, r), maxY));
+			seen = _mm_and_ps(seen, _mm_cmpgt_ps(_mm_add_ps(py, r), minY));
+			mask |= _mm_movemask_ps(seen) << (4 * k);
+		}
+
+		// Widen the 8 lane numbers to 32 bits and add the block's start
+		__m128i lanes8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(COMPACT.lanes[mask]));
+		__m128i lanes16 = _mm_unpacklo_epi8(lanes8, zeroi);
+		__m128i first = _mm_set1_epi32(static_cast<int>(base));
+		__m128i low = _mm_add_epi32(_mm_unpacklo_epi16(lanes16, zeroi), first);
+		__m128i high = _mm_add_epi32(_mm_unpackhi_epi16(lanes16, zeroi), first);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(visible + n), low);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(visible + n + 4), high);
+		n += static_cast<size_t>(countSetBits(static_cast<uint64_t>(mask)));
+	}
+	return cullRange(view, x, y, radius, radiusScale, full, count, visible, n);
+}
+
+
+TARGET_AVX2
+size_t cullCirclesAVX2(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible) {
+	size_t full = count / BLOCK * BLOCK;
+	size_t n = 0;
+
+	const __m256 minX = _mm256_set1_ps(view.min.x);
+	const __m256 minY = _mm256_set1_ps(view.min.y);
+	const __m256 maxX = _mm256_set1_ps(view.max.x);
+	const __m256 maxY = _mm256_set1_ps(view.max.y);
+	const __m256 scale = _mm256_set1_ps(radiusScale);
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (size_t base = 0; base < full; base += BLOCK) {
+		__m256 px = _mm256_loadu_ps(x + base);
+		__m256 py = _mm256_loadu_ps(y + base);
+		__m256 r = _mm256_mul_ps(_mm256_loadu_ps(radius + base), scale);
+
+		__m256 seen = _mm256_cmp_ps(r, zero, _CMP_GT_OQ);
+		seen = _mm256_and_ps(seen, _mm256_cmp_ps(_mm256_sub_ps(px, r), maxX, _CMP_LT_OQ));
+		seen = _mm256_and_ps(seen, _mm256_cmp_ps(_mm256_add_ps(px, r), minX, _CMP_GT_OQ));
+		seen = _mm256_and_ps(seen, _mm256_cmp_ps(_mm256_sub_ps(py, r), maxY, _CMP_LT_OQ));
+		seen = _mm256_and_ps(seen, _mm256_cmp_ps(_mm256_add_ps(py, r), minY, _CMP_GT_OQ));
+		int mask = _mm256_movemask_ps(seen);
+
+		__m128i lanes8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(COMPACT.lanes[mask]));
+		__m256i indices = _mm256_add_epi32(_mm256_cvtepu8_epi32(lanes8), _mm256_set1_epi32(static_cast<int>(base)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + n), indices);
+		n += static_cast<size_t>(countSetBits(static_cast<uint64_t>(mask)));
+	}
+	return cullRange(view, x, y, radius, radiusScale, full, count, visible, n);
+}
+
+#else
+
+// Never selected on non-x86 builds, but keep the symbols so benchmarks link
+size_t cullCirclesSSE2(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible) {
+	return cullCirclesScalar(view, x, y, radius, radiusScale, count, visible);
+}
+
+size_t cullCirclesAVX2(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible) {
+	return cullCirclesScalar(view, x, y, radius, radiusScale, count, visible);
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Vectorized visibility culling: which of these circles can the camera see.
+//
+// Tests packed x, y and radius arrays against a view rectangle and writes
+// the indices of the circles that overlap it to a compact list, in
+// increasing order, for the renderer to build its instances from. Nothing
+// off screen is uploaded or drawn. Circles with radius 0 (e.g. things still
+// popping in) count as not visible.
+//
+// The SIMD paths test 8 circles at a time, then left-pack the indices of
+// the visible ones with a table lookup on the comparison mask instead of a
+// branch per circle: all 8 slots are stored and the output advances by the
+// number that were visible. As with orbitHitMask(), the best implementation
+// the CPU supports is picked at runtime (see detectSimdLevel()).
+//
+// Example:
+//		std::vector<uint32_t> visible(count);
+//		size_t n = cullCircles(view, x, y, scale, 1.0f, count, visible.data());
+//		for (size_t v = 0; v < n; v++) draw(visible[v]);
+//------------------------------------------------------------------------------
+
+#include "OrbitKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+
+// The part of the world the camera sees
+struct ViewRect {
+	glm::vec2 min;
+	glm::vec2 max;
+};
+
+
+// Writes the index of every circle that overlaps view to visible and
+// returns how many there are. Circle i is centered on (x[i], y[i]) and has
+// radius radius[i] * radiusScale. visible needs room for count indices.
+// Uses the implementation for detectSimdLevel().
+size_t cullCircles(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible);
+
+// The individual implementations, for benchmarking. All give the same
+// result; calling one the CPU does not support is undefined.
+size_t cullCirclesScalar(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible);
+size_t cullCirclesSSE2(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible);
+size_t cullCirclesAVX2(const ViewRect& view, const float* x, const float* y, const float* radius, float radiusScale, size_t count, uint32_t* visible);
@@ -0,0 +1,151 @@
+#include "EntityStore.h"
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+
+
+EntityHandle EntityStore::create(EntityKind k, glm::vec2 position, float s) {
+	uint32_t slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = static_cast<uint32_t>(slotGeneration.size());
+		slotGeneration.push_back(0);
+		slotIndex.push_back(0);
+	}
+
+	slotIndex[slot] = static_cast<uint32_t>(kind.size());
+	denseSlot.push_back(slot);
+
+	x.push_back(position.x);
+	y.push_back(position.y);
+	targetX.push_back(position.x);
+	targetY.push_back(position.y);
+	rotationCos.push_back(1.0f);
+	rotationSin.push_back(0.0f);
+	directionX.push_back(0.0f);
+	directionY.push_back(1.0f);
+	scale.push_back(s);
+	kind.push_back(k);
+
+	return EntityHandle{ slot, slotGeneration[slot] };
+}
+
+
+void EntityStore::createMany(EntityKind k, const float* px, const float* py, size_t count, float s) {
+	size_t first = kind.size();
+	size_t n = first + count;
+
+	x.insert(x.end(), px, px + count);
+	y.insert(y.end(), py, py + count);
+	targetX.insert(targetX.end(), px, px + count);
+	targetY.insert(targetY.end(), py, py + count);
+	rotationCos.resize(n, 1.0f);
+	rotationSin.resize(n, 0.0f);
+	directionX.resize(n, 0.0f);
+	directionY.resize(n, 1.0f);
+	scale.resize(n, s);
+	kind.resize(n, k);
+
+	// Recycle free slots first, the same as create() would, then add new
+	// slots for the rest all at once
+	denseSlot.resize(n);
+	size_t recycled = std::min(count, freeSlots.size());
+	const uint32_t* nextFree = freeSlots.data() + freeSlots.size();
+	size_t i = first;
+	for (; i < first + recycled; i++) {
+		uint32_t slot = *--nextFree;
+		slotIndex[slot] = static_cast<uint32_t>(i);
+		denseSlot[i] = slot;
+	}
+	freeSlots.resize(freeSlots.size() - recycled);
+
+	uint32_t slot = static_cast<uint32_t>(slotGeneration.size());
+	slotGeneration.resize(slotGeneration.size() + (n - i), 0);
+	slotIndex.resize(slotGeneration.size());
+	for (; i < n; i++, slot++) {
+		slotIndex[slot] = static_cast<uint32_t>(i);
+		denseSlot[i] = slot;
+	}
+}
+
+
+void EntityStore::destroy(EntityHandle handle) {
+	assert(isAlive(handle) && "destroying a stale entity handle");
+
+	size_t index = slotIndex[handle.slot];
+	size_t last = kind.size() - 1;
+
+	// Swap-remove: move the last entity into the hole so the arrays stay packed
+	if (index != last) {
+		for (std::vector<float>* component : { &x, &y, &targetX, &targetY, &rotationCos, &rotationSin, &directionX, &directionY, &scale }) {
+			(*component)[index] = (*component)[last];
+		}
+		kind[index] = kind[last];
+
+		uint32_t movedSlot = denseSlot[last];
+		denseSlot[index] = movedSlot;
+		slotIndex[movedSlot] = static_cast<uint32_t>(index);
+	}
+
+	for (std::vector<float>* component : { &x, &y, &targetX, &targetY, &rotationCos, &rotationSin, &directionX, &directionY, &scale }) {
+		component->pop_back();
+	}
+	kind.pop_back();
+	denseSlot.pop_back();
+
+	// Invalidate outstanding handles to this slot, then recycle it
+	slotGeneration[handle.slot]++;
+	freeSlots.push_back(handle.slot);
+}
+
+
+void EntityStore::reserve(size_t capacity) {
+	for (std::vector<float>* component : { &x, &y, &targetX, &targetY, &rotationCos, &rotationSin, &directionX, &directionY, &scale }) {
+		component->reserve(capacity);
+	}
+	kind.reserve(capacity);
+	denseSlot.reserve(capacity);
+	slotGeneration.reserve(capacity);
+	slotIndex.reserve(capacity);
+	freeSlots.reserve(capacity);
+}
+
+
+void EntityStore::clear() {
+	size_t freed = freeSlots.size();
+	freeSlots.resize(freed + denseSlot.size());
+	for (size_t i = 0; i < denseSlot.size(); i++) {
+		uint32_t slot = denseSlot[i];
+		slotGeneration[slot]++;
+		freeSlots[freed + i] = slot;
+	}
+
+	for (std::vector<float>* component : { &x, &y, &targetX, &targetY, &rotationCos, &rotationSin, &directionX, &directionY, &scale }) {
+		component->clear();
+	}
+	kind.clear();
+	denseSlot.clear();
+}
+
+
+bool EntityStore::isAlive(EntityHandle handle) const {
+	// Every destroy bumps the slot's generation, so a matching generation
+	// means the slot still holds the entity the handle was created for.
+	return handle.slot < slotGeneration.size() && slotGeneration[handle.slot] == handle.generation;
+}
+
+
+size_t EntityStore::indexOf(EntityHandle handle) const {
+	assert(isAlive(handle) && "using a stale entity handle");
+	return slotIndex[handle.slot];
+}
+
+
+EntityHandle EntityStore::handleAt(size_t index) const {
+	uint32_t slot = denseSlot[index];
+	return EntityHandle{ slot, slotGeneration[slot] };
+}
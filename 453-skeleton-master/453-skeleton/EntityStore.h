@@ -0,0 +1,101 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Structure-of-arrays storage for game entities.
+//
+// Each component lives in its own contiguous array and the live entities are
+// always packed at [0, size()). Systems that update one or two components
+// (easing, collision) only stream through the arrays they touch, and the
+// loops are simple enough for the compiler to vectorize.
+//
+// Because destroying an entity moves the last entity into its place, dense
+// indices are only stable until the next destroy(). Anything that needs to
+// refer to an entity for longer holds an EntityHandle instead: a slot in an
+// indirection table plus the generation that slot had when the entity was
+// created. Slots are recycled through a free list and their generation is
+// bumped on every destroy, so a handle to a destroyed entity can be detected
+// (and is asserted on in debug builds) rather than silently aliasing
+// whichever entity reuses the slot.
+//
+// Heavy per-kind resources (textures, geometry) are not stored per entity;
+// the renderer looks them up by EntityKind.
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+enum class EntityKind : uint8_t {
+	Ship,
+	Diamond
+};
+
+
+struct EntityHandle {
+	uint32_t slot = 0;
+	uint32_t generation = 0;
+
+	bool operator==(const EntityHandle& other) const { return slot == other.slot && generation == other.generation; }
+	bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+
+class EntityStore {
+
+public:
+	// Hot simulation components, indexed by dense index
+	std::vector<float> x;            // current position (v1)
+	std::vector<float> y;            // current position (v2)
+	std::vector<float> targetX;      // position being eased towards (target_v1)
+	std::vector<float> targetY;      // position being eased towards (target_v2)
+	std::vector<float> rotationCos;  // current rotation as (cos theta, sin theta),
+	std::vector<float> rotationSin;  // eased towards rotationFacing(direction)
+	std::vector<float> directionX;   // unit facing direction
+	std::vector<float> directionY;
+	std::vector<float> scale;        // scaling_factor
+
+	// Cold components
+	std::vector<EntityKind> kind;
+
+	// Adds an entity at rest at position, facing up. Does not allocate as
+	// long as size() stays within what was reserve()d.
+	EntityHandle create(EntityKind k, glm::vec2 position, float s);
+
+	// Adds count entities at rest at (px[i], py[i]), facing up, in one pass
+	// per component array. Their handles are handleAt(size() - count + i).
+	void createMany(EntityKind k, const float* px, const float* py, size_t count, float s);
+
+	// Removes the entity, moving the last entity into its dense index.
+	void destroy(EntityHandle handle);
+
+	void reserve(size_t capacity);
+
+	// Destroys every entity. All outstanding handles become stale.
+	void clear();
+
+	size_t size() const { return kind.size(); }
+
+	// Every slot ever handed out, live or free. Handle slots are below this.
+	size_t slotCount() const { return slotGeneration.size(); }
+
+	bool isAlive(EntityHandle handle) const;
+
+	// Dense index of a live entity, valid until the next destroy()
+	size_t indexOf(EntityHandle handle) const;
+	EntityHandle handleAt(size_t index) const;
+
+	glm::vec2 position(size_t index) const { return glm::vec2(x[index], y[index]); }
+	glm::vec3 direction(size_t index) const { return glm::vec3(directionX[index], directionY[index], 0.0f); }
+
+private:
+	// slot -> current generation and dense index (only meaningful while alive)
+	std::vector<uint32_t> slotGeneration;
+	std::vector<uint32_t> slotIndex;
+	std::vector<uint32_t> freeSlots;
+
+	// dense index -> slot
+	std::vector<uint32_t> denseSlot;
+};
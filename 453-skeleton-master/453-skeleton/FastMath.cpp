@@ -0,0 +1,223 @@
+#include "FastMath.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// SSE2 is part of every x86-64 CPU, so there is nothing to detect at runtime
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAST_MATH_SSE2 1
+#include <emmintrin.h>
+#else
+#define FAST_MATH_SSE2 0
+#endif
+
+
+namespace {
+
+	const float TWO_OVER_PI = 0.636619772367581343f;
+
+	// pi / 2 in three parts. The first two have few enough significant bits
+	// that k * part is exact for the k this is accurate for.
+	const float PI_OVER_2_A = 1.5703125f;
+	const float PI_OVER_2_B = 4.837512969970703125e-4f;
+	const float PI_OVER_2_C = 7.54978995489188216e-8f;
+
+	const float PI = 3.14159265358979324f;
+	const float PI_OVER_2 = 1.57079632679489662f;
+
+	// Cephes sinf/cosf polynomials, minimax on [-pi/4, pi/4]
+	const float SIN_1 = -1.6666654611e-1f;
+	const float SIN_2 = 8.3321608736e-3f;
+	const float SIN_3 = -1.9515295891e-4f;
+	const float COS_1 = 4.166664568298827e-2f;
+	const float COS_2 = -1.388731625493765e-3f;
+	const float COS_3 = 2.443315711809948e-5f;
+
+	// atan(a) ~ a * (A_1 + A_3 a^2 + ... + A_11 a^10) on [0, 1]
+	const float ATAN_1 = 0.99997726f;
+	const float ATAN_3 = -0.33262347f;
+	const float ATAN_5 = 0.19354346f;
+	const float ATAN_7 = -0.11643287f;
+	const float ATAN_9 = 0.05265332f;
+	const float ATAN_11 = -0.01172120f;
+
+#if FAST_MATH_SSE2
+
+	// Every function below works on four floats at once. The scalar entry
+	// points run them on one lane, so scalar and array results always match.
+
+	inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	inline void sinCos4(__m128 x, __m128& s, __m128& c) {
+		// Nearest multiple of pi / 2 and what's left over
+		__m128i k = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+		__m128 kf = _mm_cvtepi32_ps(k);
+		__m128 r = _mm_sub_ps(x, _mm_mul_ps(kf, _mm_set1_ps(PI_OVER_2_A)));
+		r = _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(PI_OVER_2_B)));
+		r = _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(PI_OVER_2_C)));
+		__m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_3), r2), _mm_set1_ps(SIN_2));
+		ps = _mm_add_ps(_mm_mul_ps(ps, r2), _mm_set1_ps(SIN_1));
+		ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, r2), r), r);
+
+		__m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_3), r2), _mm_set1_ps(COS_2));
+		pc = _mm_add_ps(_mm_mul_ps(pc, r2), _mm_set1_ps(COS_1));
+		pc = _mm_mul_ps(_mm_mul_ps(pc, r2), r2);
+		pc = _mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), r2));
+		pc = _mm_add_ps(pc, _mm_set1_ps(1.0f));
+
+		// Odd quadrants swap sin and cos; sin is negated in quadrants 2 and
+		// 3, cos in quadrants 1 and 2
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(k, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(k, _mm_set1_epi32(2)), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(k, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+		s = _mm_xor_ps(select(swap, pc, ps), sinSign);
+		c = _mm_xor_ps(select(swap, ps, pc), cosSign);
+	}
+
+	inline __m128 atan2_4(__m128 y, __m128 x) {
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		__m128 ax = _mm_andnot_ps(signBit, x);
+		__m128 ay = _mm_andnot_ps(signBit, y);
+
+		// Reduce to atan(a) for a in [0, 1]. 0 / 0 makes NaN, masked to 0.
+		__m128 hi = _mm_max_ps(ax, ay);
+		__m128 lo = _mm_min_ps(ax, ay);
+		__m128 a = _mm_and_ps(_mm_div_ps(lo, hi), _mm_cmpgt_ps(hi, _mm_setzero_ps()));
+		__m128 a2 = _mm_mul_ps(a, a);
+
+		__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ATAN_11), a2), _mm_set1_ps(ATAN_9));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(ATAN_7));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(ATAN_5));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(ATAN_3));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(ATAN_1));
+		p = _mm_mul_ps(p, a);
+
+		// Back out to the octant (y, x) is in
+		p = select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(PI_OVER_2), p), p);
+		p = select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), p), p);
+		return _mm_or_ps(p, _mm_and_ps(y, signBit));
+	}
+
+#else
+
+	inline float copySignBit(float magnitude, float sign) {
+		uint32_t m, s;
+		std::memcpy(&m, &magnitude, sizeof(m));
+		std::memcpy(&s, &sign, sizeof(s));
+		m = (m & 0x7FFFFFFFu) | (s & 0x80000000u);
+		std::memcpy(&magnitude, &m, sizeof(m));
+		return magnitude;
+	}
+
+	inline void sinCos1(float x, float& s, float& c) {
+		float kf = std::nearbyint(x * TWO_OVER_PI);
+		int32_t k = static_cast<int32_t>(kf);
+		float r = x - kf * PI_OVER_2_A;
+		r = r - kf * PI_OVER_2_B;
+		r = r - kf * PI_OVER_2_C;
+		float r2 = r * r;
+
+		float ps = ((SIN_3 * r2 + SIN_2) * r2 + SIN_1) * r2 * r + r;
+		float pc = ((COS_3 * r2 + COS_2) * r2 + COS_1) * r2 * r2 - 0.5f * r2 + 1.0f;
+
+		bool swap = (k & 1) != 0;
+		s = swap ? pc : ps;
+		c = swap ? ps : pc;
+		if (k & 2) s = -s;
+		if ((k + 1) & 2) c = -c;
+	}
+
+	inline float atan2_1(float y, float x) {
+		float ax = std::abs(x);
+		float ay = std::abs(y);
+		float hi = ax > ay ? ax : ay;
+		float lo = ax > ay ? ay : ax;
+		float a = hi > 0.0f ? lo / hi : 0.0f;
+		float a2 = a * a;
+
+		float p = (((((ATAN_11 * a2 + ATAN_9) * a2 + ATAN_7) * a2 + ATAN_5) * a2 + ATAN_3) * a2 + ATAN_1) * a;
+		if (ay > ax) p = PI_OVER_2 - p;
+		if (x < 0.0f) p = PI - p;
+		return copySignBit(p, y);
+	}
+
+#endif
+}
+
+
+float fastSin(float x) {
+	float s, c;
+	fastSinCos(x, s, c);
+	return s;
+}
+
+
+float fastCos(float x) {
+	float s, c;
+	fastSinCos(x, s, c);
+	return c;
+}
+
+
+void fastSinCos(float x, float& s, float& c) {
+#if FAST_MATH_SSE2
+	__m128 vs, vc;
+	sinCos4(_mm_set1_ps(x), vs, vc);
+	s = _mm_cvtss_f32(vs);
+	c = _mm_cvtss_f32(vc);
+#else
+	sinCos1(x, s, c);
+#endif
+}
+
+
+float fastAtan2(float y, float x) {
+#if FAST_MATH_SSE2
+	return _mm_cvtss_f32(atan2_4(_mm_set1_ps(y), _mm_set1_ps(x)));
+#else
+	return atan2_1(y, x);
+#endif
+}
+
+
+void fastSinCos(const float* x, float* s, float* c, size_t count) {
+#if FAST_MATH_SSE2
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 vs, vc;
+		sinCos4(_mm_loadu_ps(x + i), vs, vc);
+		_mm_storeu_ps(s + i, vs);
+		_mm_storeu_ps(c + i, vc);
+	}
+	for (; i < count; i++) {
+		fastSinCos(x[i], s[i], c[i]);
+	}
+#else
+	for (size_t i = 0; i < count; i++) {
+		sinCos1(x[i], s[i], c[i]);
+	}
+#endif
+}
+
+
+void fastAtan2(const float* y, const float* x, float* out, size_t count) {
+#if FAST_MATH_SSE2
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(out + i, atan2_4(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+	}
+	for (; i < count; i++) {
+		out[i] = fastAtan2(y[i], x[i]);
+	}
+#else
+	for (size_t i = 0; i < count; i++) {
+		out[i] = atan2_1(y[i], x[i]);
+	}
+#endif
+}
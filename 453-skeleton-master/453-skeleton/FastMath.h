@@ -0,0 +1,42 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Polynomial sin, cos and atan2 for float inputs, one at a time or over
+// arrays.
+//
+// sin and cos reduce the argument to [-pi/4, pi/4] around the nearest
+// multiple of pi/2 (subtracting pi/2 in three parts so little precision is
+// lost), then evaluate the Cephes minimax polynomials for that range and
+// pick sin or cos and the sign from the quadrant. atan2 evaluates a degree
+// 11 odd polynomial for atan on [0, 1] and folds the result into the right
+// octant.
+//
+// Measured maximum absolute error against double precision std functions
+// (perf/perf_fast_math.cpp checks these on every run):
+//		fastSin, fastCos	1e-7 for |x| <= 8192 (about 1 ulp near 1)
+//		fastAtan2			2e-6 radians for any finite y, x
+// Past |x| = 8192 the argument reduction gets gradually worse; game angles
+// never come close. fastAtan2(0, 0) is 0.
+//
+// The array versions process four values per SSE2 instruction on x86 and
+// give bit for bit the same results as the scalar versions, which makes
+// them safe to mix. Neither is used by the simulation: gameplay rotation is
+// kept as unit complex numbers (see GameMath.h) and needs no trig at all.
+//
+// Example:
+//		fastSinCos(theta.data(), sines.data(), cosines.data(), theta.size());
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+
+
+float fastSin(float x);
+float fastCos(float x);
+void fastSinCos(float x, float& s, float& c);
+float fastAtan2(float y, float x);
+
+// s[i] = fastSin(x[i]) and c[i] = fastCos(x[i])
+void fastSinCos(const float* x, float* s, float* c, size_t count);
+
+// out[i] = fastAtan2(y[i], x[i])
+void fastAtan2(const float* y, const float* x, float* out, size_t count);
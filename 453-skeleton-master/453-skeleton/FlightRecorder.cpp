@@ -0,0 +1,299 @@
+#include "FlightRecorder.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <utility>
+
+
+namespace {
+
+	// Small per-thread id so traces can separate threads without storing
+	// the (large, platform specific) std::thread::id in every event.
+	uint8_t threadIndex() {
+		static std::atomic<uint8_t> next{ 0 };
+		thread_local uint8_t index = next.fetch_add(1);
+		return index;
+	}
+
+	size_t roundUpToPowerOfTwo(size_t n) {
+		size_t result = 1;
+		while (result < n) {
+			result <<= 1;
+		}
+		return result;
+	}
+
+	void writeEscaped(std::ostream& out, const char* str, size_t maxLength) {
+		for (size_t i = 0; i < maxLength && str[i] != '\0'; i++) {
+			char c = str[i];
+			if (c == '"' || c == '\\') {
+				out << '\\' << c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				out << ' ';
+			}
+			else {
+				out << c;
+			}
+		}
+	}
+
+	const char* categoryName(FlightRecorder::EventType type) {
+		switch (type) {
+		case FlightRecorder::EventType::Scope:     return "scope";
+		case FlightRecorder::EventType::Input:     return "input";
+		case FlightRecorder::EventType::GLMessage: return "gl";
+		case FlightRecorder::EventType::Frame:     return "frame";
+		case FlightRecorder::EventType::Hitch:     return "hitch";
+		}
+		return "unknown";
+	}
+
+	// Number of frames used to compute the median frame time.
+	constexpr size_t FRAME_HISTORY = 120;
+}
+
+
+FlightRecorder& FlightRecorder::get() {
+	static FlightRecorder recorder;
+	return recorder;
+}
+
+
+FlightRecorder::FlightRecorder(size_t capacity)
+	: ring(roundUpToPowerOfTwo(capacity))
+	, mask(ring.size() - 1)
+	, head(0)
+	, messages(MESSAGE_CAPACITY)
+	, messageHead(0)
+	, epoch(std::chrono::steady_clock::now())
+	, enabled(true)
+	, writer()
+	, frameTimes()
+	, sortScratch()
+	, lastFrameEndNs(0)
+	, lastFrameMs(0.0f)
+	, medianFrameMs(0.0f)
+	, frameCount(0)
+	, budgetMultiplier(2.0f)
+	, minimumBudgetMs(4.0f)
+	, cooldownFrames(FRAME_HISTORY)
+	, lastDumpFrame(0)
+	, dumpCount(0)
+	, outputPrefix("hitch")
+{
+	static_assert(sizeof(Slot) == 64, "A ring slot should fill exactly one cache line");
+	frameTimes.reserve(FRAME_HISTORY);
+	sortScratch.reserve(FRAME_HISTORY);
+}
+
+
+FlightRecorder::~FlightRecorder() {
+	if (writer.joinable()) writer.join();
+}
+
+
+int64_t FlightRecorder::now() const {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - epoch
+	).count();
+}
+
+
+void FlightRecorder::record(Event event) {
+	// A single atomic increment is the only synchronisation between
+	// writers. They never wait; old events are simply overwritten.
+	uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = ring[index & mask];
+	event.thread = threadIndex();
+
+	// Readers leave the slot alone until the sequence says it holds this
+	// event, which is only stored once every field is
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.event = event;
+	slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+
+void FlightRecorder::recordScope(const char* name, int64_t startNs, int64_t endNs) {
+	if (!isEnabled()) return;
+	record({ startNs, endNs - startNs, name, 0, 0, EventType::Scope, 0, 0 });
+}
+
+
+void FlightRecorder::recordInput(const char* name, int a, int b) {
+	if (!isEnabled()) return;
+	record({ now(), 0, name, a, b, EventType::Input, 0, 0 });
+}
+
+
+void FlightRecorder::recordGLMessage(unsigned int id, unsigned int severity, const char* message) {
+	if (!isEnabled()) return;
+	record({ now(), 0, "gl", static_cast<int32_t>(id), static_cast<int32_t>(severity), EventType::GLMessage, 0, recordText(message) });
+}
+
+
+uint64_t FlightRecorder::recordText(const char* text) {
+	uint64_t index = messageHead.fetch_add(1, std::memory_order_relaxed);
+	MessageSlot& slot = messages[index % MESSAGE_CAPACITY];
+
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	size_t length = std::strlen(text);
+	if (length < MESSAGE_LENGTH) {
+		std::memcpy(slot.text, text, length + 1);
+	}
+	else {
+		// Say that it was cut short rather than leave it looking complete
+		std::memcpy(slot.text, text, MESSAGE_LENGTH - 4);
+		std::memcpy(slot.text + MESSAGE_LENGTH - 4, "...", 4);
+	}
+	slot.sequence.store(index + 1, std::memory_order_release);
+	return index + 1;
+}
+
+
+bool FlightRecorder::endFrame() {
+	int64_t frameEndNs = now();
+	int64_t frameStartNs = lastFrameEndNs;
+	lastFrameEndNs = frameEndNs;
+	frameCount++;
+
+	// The first frame has no meaningful start.
+	if (frameCount == 1 || !isEnabled()) {
+		return false;
+	}
+
+	lastFrameMs = static_cast<float>(frameEndNs - frameStartNs) * 1e-6f;
+
+	record({ frameStartNs, frameEndNs - frameStartNs, "frame", static_cast<int32_t>(frameCount), 0, EventType::Frame, 0, 0 });
+
+	// Judge this frame against the frames before it, then add it to the history.
+	bool hitch = false;
+	if (frameTimes.size() == FRAME_HISTORY) {
+		float budget = std::max(medianFrameMs * budgetMultiplier, minimumBudgetMs);
+		hitch = lastFrameMs > budget && frameCount - lastDumpFrame > cooldownFrames;
+	}
+
+	if (frameTimes.size() < FRAME_HISTORY) {
+		frameTimes.push_back(lastFrameMs);
+	}
+	else {
+		frameTimes[frameCount % FRAME_HISTORY] = lastFrameMs;
+	}
+
+	sortScratch.assign(frameTimes.begin(), frameTimes.end());
+	auto middle = sortScratch.begin() + sortScratch.size() / 2;
+	std::nth_element(sortScratch.begin(), middle, sortScratch.end());
+	medianFrameMs = *middle;
+
+	if (hitch) {
+		record({ frameStartNs, frameEndNs - frameStartNs, "hitch", static_cast<int32_t>(frameCount), 0, EventType::Hitch, 0, 0 });
+
+		lastDumpFrame = frameCount;
+		std::string path = fmt::format("{}_{}.json", outputPrefix, dumpCount++);
+		Log::warn("FLIGHT_RECORDER frame {} took {:.2f}ms (median {:.2f}ms), dumping trace to {}",
+			frameCount, lastFrameMs, medianFrameMs, path);
+
+		// Only the copy happens here. The cooldown means the last trace has
+		// long been written by now, so joining doesn't wait.
+		if (writer.joinable()) writer.join();
+		writer = std::thread([path, trace = snapshot()] { writeTrace(path, trace); });
+	}
+	return hitch;
+}
+
+
+bool FlightRecorder::dump(const std::string& path) const {
+	return writeTrace(path, snapshot());
+}
+
+
+FlightRecorder::Snapshot FlightRecorder::snapshot() const {
+	uint64_t end = head.load(std::memory_order_acquire);
+	uint64_t begin = end > ring.size() ? end - ring.size() : 0;
+
+	Snapshot trace;
+	std::vector<Event>& events = trace.events;
+	events.reserve(static_cast<size_t>(end - begin));
+	for (uint64_t i = begin; i < end; i++) {
+		// Skip events still being written, and ones overwritten by a newer
+		// event before or while they were copied
+		const Slot& slot = ring[i & mask];
+		if (slot.sequence.load(std::memory_order_acquire) != i + 1) continue;
+
+		Event e = slot.event;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != i + 1) continue;
+
+		// The same check for the message's text, which may have been
+		// overwritten by newer messages even though the event wasn't
+		if (e.message != 0) {
+			const MessageSlot& text = messages[(e.message - 1) % MESSAGE_CAPACITY];
+			std::string copy;
+			bool complete = text.sequence.load(std::memory_order_acquire) == e.message;
+			if (complete) {
+				copy.assign(text.text, std::find(text.text, text.text + MESSAGE_LENGTH, '\0'));
+				std::atomic_thread_fence(std::memory_order_acquire);
+				complete = text.sequence.load(std::memory_order_relaxed) == e.message;
+			}
+			if (complete) {
+				trace.texts.push_back(std::move(copy));
+				e.message = trace.texts.size();
+			}
+			else {
+				e.message = 0;
+			}
+		}
+
+		events.push_back(e);
+	}
+	return trace;
+}
+
+
+bool FlightRecorder::writeTrace(const std::string& path, const Snapshot& trace) {
+	std::ofstream out(path);
+	if (!out) {
+		Log::error("FLIGHT_RECORDER unable to open {}", path);
+		return false;
+	}
+
+	// Timestamps are in microseconds; keep nanosecond resolution.
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (const Event& e : trace.events) {
+		if (!first) out << ",\n";
+		first = false;
+
+		out << "{\"name\":\"";
+		writeEscaped(out, e.name, 64);
+		out << "\",\"cat\":\"" << categoryName(e.type) << "\"";
+		out << ",\"pid\":0,\"tid\":" << static_cast<int>(e.thread);
+		out << ",\"ts\":" << static_cast<double>(e.startNs) * 1e-3;
+
+		if (e.type == EventType::Scope || e.type == EventType::Frame || e.type == EventType::Hitch) {
+			out << ",\"ph\":\"X\",\"dur\":" << static_cast<double>(e.durationNs) * 1e-3;
+		}
+		else {
+			out << ",\"ph\":\"i\",\"s\":\"g\"";
+		}
+
+		out << ",\"args\":{\"a\":" << e.a << ",\"b\":" << e.b;
+		if (e.message != 0) {
+			const std::string& text = trace.texts[e.message - 1];
+			out << ",\"text\":\"";
+			writeEscaped(out, text.c_str(), text.size());
+			out << "\"";
+		}
+		out << "}}";
+	}
+	out << "\n]}\n";
+	return true;
+}
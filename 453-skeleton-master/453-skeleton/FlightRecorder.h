@@ -0,0 +1,190 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// An always-on "flight recorder" for tracking down hitches.
+//
+// Profiler scopes, input events and OpenGL debug messages are written into a
+// fixed size in-memory ring that only ever holds the last few seconds of
+// activity. Nothing is written to disk in the steady state. When a frame takes
+// longer than the budget (a multiple of the median of recent frame times) the
+// ring is dumped to a Chrome trace file (open it in chrome://tracing or
+// https://ui.perfetto.dev) so the frames leading up to the hitch can be
+// inspected after the fact.
+//
+// Any thread may record. Each slot of the ring carries the sequence number of
+// the event it holds, stored after the event itself, so a dump can tell a
+// complete event from one that is still being written (or was overwritten
+// while it was being copied) and leave it out. A hitch copies the ring and
+// writes the file on a background thread, so the dump doesn't add a second
+// hitch of its own.
+//
+// OpenGL debug messages are rare and too long for a ring slot, so their text
+// goes into a second, smaller ring and the event only refers to it. That ring
+// keeps the last MESSAGE_CAPACITY messages. Messages longer than
+// MESSAGE_LENGTH - 1 characters are cut short and end in "..." in the trace.
+// A dump that reaches further back than the last MESSAGE_CAPACITY messages
+// shows the older ones' id and severity without their text.
+//
+// Example:
+//		{
+//			ProfileScope scope("update");
+//			...
+//		}
+//		FlightRecorder::get().endFrame();
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class FlightRecorder {
+
+public:
+	enum class EventType : uint8_t {
+		Scope,
+		Input,
+		GLMessage,
+		Frame,
+		Hitch
+	};
+
+	// Names must be string literals (or otherwise outlive the recorder)
+	// since only the pointer is stored.
+	struct Event {
+		int64_t startNs;
+		int64_t durationNs;
+		const char* name;
+		int32_t a;
+		int32_t b;
+		EventType type;
+		uint8_t thread;
+		uint64_t message;	// sequence number of a GL message's text, 0 if none
+	};
+
+	static constexpr size_t MESSAGE_CAPACITY = 64;
+	static constexpr size_t MESSAGE_LENGTH = 1024;
+
+	static FlightRecorder& get();
+
+	FlightRecorder(size_t capacity = 1 << 16);
+	~FlightRecorder();
+
+	// The ring is shared between threads and refers to itself by index,
+	// so it can be neither copied nor moved.
+	FlightRecorder(const FlightRecorder&) = delete;
+	FlightRecorder operator=(const FlightRecorder&) = delete;
+
+	// Public interface
+	int64_t now() const;
+
+	void recordScope(const char* name, int64_t startNs, int64_t endNs);
+	void recordInput(const char* name, int a, int b);
+	void recordGLMessage(unsigned int id, unsigned int severity, const char* message);
+
+	// Marks the end of a frame. Returns true if the frame was a hitch and
+	// the ring was dumped to disk.
+	bool endFrame();
+
+	// Writes the current contents of the ring to a Chrome trace file, on
+	// the calling thread
+	bool dump(const std::string& path) const;
+
+	void setEnabled(bool enabled_) { enabled.store(enabled_, std::memory_order_relaxed); }
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	// A frame is a hitch when it takes longer than budgetMultiplier times
+	// the median of the last few frames (and at least minimumBudgetMs).
+	void setBudgetMultiplier(float multiplier) { budgetMultiplier = multiplier; }
+	void setMinimumBudgetMs(float ms) { minimumBudgetMs = ms; }
+	void setOutputPrefix(const std::string& prefix) { outputPrefix = prefix; }
+
+	float getLastFrameMs() const { return lastFrameMs; }
+	float getMedianFrameMs() const { return medianFrameMs; }
+	uint64_t getFrameCount() const { return frameCount; }
+	int getDumpCount() const { return dumpCount; }
+
+private:
+	// Kept to one cache line so that recording never touches more than one
+	// line of the ring. sequence is 0 while the event is being written and
+	// its index in the ring plus 1 once it is complete.
+	struct alignas(64) Slot {
+		std::atomic<uint64_t> sequence{ 0 };
+		Event event;
+	};
+
+	// Text of a GL message, written and read the same way as a Slot
+	struct MessageSlot {
+		std::atomic<uint64_t> sequence{ 0 };
+		char text[MESSAGE_LENGTH];
+	};
+
+	// Complete events in the ring, oldest first, with the text of their GL
+	// messages. Event::message indexes texts, counting from 1.
+	struct Snapshot {
+		std::vector<Event> events;
+		std::vector<std::string> texts;
+	};
+
+	void record(Event event);
+	uint64_t recordText(const char* text);
+
+	Snapshot snapshot() const;
+	static bool writeTrace(const std::string& path, const Snapshot& trace);
+
+	std::vector<Slot> ring;
+	size_t mask;
+	std::atomic<uint64_t> head;
+
+	std::vector<MessageSlot> messages;
+	std::atomic<uint64_t> messageHead;
+
+	std::chrono::steady_clock::time_point epoch;
+	std::atomic<bool> enabled;
+
+	// Writes the last hitch's trace
+	std::thread writer;
+
+	// Frame timing history used to compute the median
+	std::vector<float> frameTimes;
+	std::vector<float> sortScratch;
+	int64_t lastFrameEndNs;
+	float lastFrameMs;
+	float medianFrameMs;
+	uint64_t frameCount;
+
+	float budgetMultiplier;
+	float minimumBudgetMs;
+	uint64_t cooldownFrames;
+	uint64_t lastDumpFrame;
+	int dumpCount;
+	std::string outputPrefix;
+};
+
+
+// RAII helper that records the time between its construction and
+// destruction as a scope in the flight recorder.
+class ProfileScope {
+
+public:
+	ProfileScope(const char* name)
+		: name(name)
+		, start(FlightRecorder::get().now())
+	{}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope operator=(const ProfileScope&) = delete;
+
+	~ProfileScope() {
+		FlightRecorder& recorder = FlightRecorder::get();
+		recorder.recordScope(name, start, recorder.now());
+	}
+
+private:
+	const char* name;
+	int64_t start;
+};
@@ -1,4 +1,5 @@
 #include "GLDebug.h"
+#include "FlightRecorder.h"
 #include "Log.h"
 
 #include <regex>
@@ -43,6 +44,7 @@ void GLDebug::debugOutputHandler(
     std::string format = "[OPENGL] [{}] {} #{} -- {}: {}";
     std::string message_str = message;
     message_str = std::regex_replace(message_str, std::regex("^\\s+|\\s+$"), "$1");
+    FlightRecorder::get().recordGLMessage(id, severity, message_str.c_str());
     switch (severity)
     {
         case GL_DEBUG_SEVERITY_HIGH:
@@ -1,6 +1,133 @@
 #include "GLHandles.h"
 
+#include "GLState.h"
+
 #include <algorithm> // For std::swap
+#include <stdexcept>
+
+
+GLObjectPool& GLObjectPool::get() {
+	static GLObjectPool pool;
+	return pool;
+}
+
+
+GLObjectPool::GLObjectPool()
+	: pools()
+	, released()
+	, retired()
+{}
+
+
+GLuint GLObjectPool::allocate(Kind kind) {
+	std::vector<GLuint>& pool = pools[static_cast<size_t>(kind)];
+	if (pool.empty()) refill(kind);
+
+	GLuint name = pool.back();
+	pool.pop_back();
+	return name;
+}
+
+
+void GLObjectPool::release(Kind kind, GLuint name) {
+	if (name != 0) released[static_cast<size_t>(kind)].push_back(name);
+}
+
+
+void GLObjectPool::collect() {
+	bool any = false;
+	for (const std::vector<GLuint>& names : released) any = any || !names.empty();
+
+	if (any) {
+		retired.emplace_back();
+		Retired& batch = retired.back();
+		batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		for (size_t k = 0; k < KINDS; k++) batch.names[k].swap(released[k]);
+	}
+
+	// Fences signal in the order they were put in, so stop at the first
+	// one still pending
+	size_t done = 0;
+	while (done < retired.size()) {
+		GLenum status = glClientWaitSync(retired[done].fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+		for (size_t k = 0; k < KINDS; k++) destroy(static_cast<Kind>(k), retired[done].names[k]);
+		glDeleteSync(retired[done].fence);
+		done++;
+	}
+	retired.erase(retired.begin(), retired.begin() + done);
+}
+
+
+size_t GLObjectPool::pending() const {
+	size_t count = 0;
+	for (const std::vector<GLuint>& names : released) count += names.size();
+	for (const Retired& batch : retired) {
+		for (const std::vector<GLuint>& names : batch.names) count += names.size();
+	}
+	return count;
+}
+
+
+void GLObjectPool::refill(Kind kind) {
+	std::vector<GLuint>& pool = pools[static_cast<size_t>(kind)];
+	pool.resize(POOL_SIZE);
+
+	// Created names are objects straight away; generated ones only once
+	// they are first bound, so they can't be edited by name before that
+	bool dsa = GLState::get().hasDirectStateAccess();
+	switch (kind) {
+	case Kind::VertexArray:
+		if (dsa) glCreateVertexArrays(POOL_SIZE, pool.data());
+		else glGenVertexArrays(POOL_SIZE, pool.data());
+		break;
+	case Kind::Buffer:
+		if (dsa) glCreateBuffers(POOL_SIZE, pool.data());
+		else glGenBuffers(POOL_SIZE, pool.data());
+		break;
+	case Kind::Texture:
+		if (dsa) glCreateTextures(GL_TEXTURE_2D, POOL_SIZE, pool.data());
+		else glGenTextures(POOL_SIZE, pool.data());
+		break;
+	default:
+		pool.clear();
+		throw std::runtime_error("GL_OBJECT_POOL shaders and programs can't be made in bulk");
+	}
+
+	// Hand them out in the order GL made them
+	std::reverse(pool.begin(), pool.end());
+}
+
+
+void GLObjectPool::destroy(Kind kind, const std::vector<GLuint>& names) {
+	if (names.empty()) return;
+
+	GLsizei n = static_cast<GLsizei>(names.size());
+	switch (kind) {
+	case Kind::Shader:
+		for (GLuint name : names) glDeleteShader(name);
+		break;
+	case Kind::Program:
+		for (GLuint name : names) glDeleteProgram(name);
+		break;
+	case Kind::VertexArray:
+		glDeleteVertexArrays(n, names.data());
+		break;
+	case Kind::Buffer:
+		glDeleteBuffers(n, names.data());
+		break;
+	case Kind::Texture:
+		glDeleteTextures(n, names.data());
+		break;
+	default:
+		break;
+	}
+}
+
+
+//------------------------------------------------------------------------------
+
 
 ShaderHandle::ShaderHandle(GLenum type)
 	: shaderID(glCreateShader(type))
@@ -23,7 +150,7 @@ ShaderHandle& ShaderHandle::operator=(ShaderHandle&& other) noexcept {
 
 
 ShaderHandle::~ShaderHandle() {
-	glDeleteShader(shaderID);
+	GLObjectPool::get().release(GLObjectPool::Kind::Shader, shaderID);
 }
 
 
@@ -58,7 +185,8 @@ ShaderProgramHandle& ShaderProgramHandle::operator=(ShaderProgramHandle&& other)
 
 
 ShaderProgramHandle::~ShaderProgramHandle() {
-	glDeleteProgram(programID);
+	GLState::get().forgetProgram(programID);
+	GLObjectPool::get().release(GLObjectPool::Kind::Program, programID);
 }
 
 
@@ -75,10 +203,8 @@ GLuint ShaderProgramHandle::value() const {
 
 
 VertexArrayHandle::VertexArrayHandle()
-	: vaoID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
-{
-	glGenVertexArrays(1, &vaoID);
-}
+	: vaoID(GLObjectPool::get().allocate(GLObjectPool::Kind::VertexArray))
+{}
 
 
 VertexArrayHandle::VertexArrayHandle(VertexArrayHandle&& other) noexcept
@@ -95,7 +221,8 @@ VertexArrayHandle& VertexArrayHandle::operator=(VertexArrayHandle&& other) noexc
 
 
 VertexArrayHandle::~VertexArrayHandle() {
-	glDeleteVertexArrays(1, &vaoID);
+	GLState::get().forgetVertexArray(vaoID);
+	GLObjectPool::get().release(GLObjectPool::Kind::VertexArray, vaoID);
 }
 
 
@@ -112,10 +239,8 @@ GLuint VertexArrayHandle::value() const {
 
 
 VertexBufferHandle::VertexBufferHandle()
-	: vboID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
-{
-	glGenBuffers(1, &vboID);
-}
+	: vboID(GLObjectPool::get().allocate(GLObjectPool::Kind::Buffer))
+{}
 
 
 VertexBufferHandle::VertexBufferHandle(VertexBufferHandle&& other) noexcept
@@ -132,7 +257,7 @@ VertexBufferHandle& VertexBufferHandle::operator=(VertexBufferHandle&& other) no
 
 
 VertexBufferHandle::~VertexBufferHandle() {
-	glDeleteBuffers(1, &vboID);
+	GLObjectPool::get().release(GLObjectPool::Kind::Buffer, vboID);
 }
 
 
@@ -149,10 +274,8 @@ GLuint VertexBufferHandle::value() const {
 //------------------------------------------------------------------------------
 
 TextureHandle::TextureHandle()
-	: textureID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
-{
-	glGenTextures(1, &textureID);
-}
+	: textureID(GLObjectPool::get().allocate(GLObjectPool::Kind::Texture))
+{}
 
 
 TextureHandle::TextureHandle(TextureHandle&& other) noexcept
@@ -168,7 +291,8 @@ TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
 
 
 TextureHandle::~TextureHandle() {
-	glDeleteTextures(1, &textureID);
+	GLState::get().forgetTexture(textureID);
+	GLObjectPool::get().release(GLObjectPool::Kind::Texture, textureID);
 }
 
 
@@ -2,6 +2,85 @@
 
 #include <GL/glew.h>
 
+#include <cstddef>
+#include <vector>
+
+
+// Where the handles below get their names from and give them back to.
+//
+// Buffer, vertex array and texture names are generated (or, with direct
+// state access, created) POOL_SIZE at a time, so spawning many objects
+// costs one driver call per batch rather than one per object.
+//
+// Names given back aren't deleted straight away: the GPU may still be
+// reading the object for a draw that was queued earlier, and deleting it
+// then can make the driver stall until that draw is done. Instead collect()
+// puts a fence after everything released since the last call, and deletes
+// those names, all of one kind in one call, once the fence has signaled.
+// Call it once a frame. Anything not collected yet is left to the driver to
+// clean up with the context.
+//
+// Released names are never handed out again from the pool, since a deleted
+// object's storage and state would come with it; GL reuses the name itself
+// once it is actually deleted, which is why the handles tell GLState too.
+//
+// Example:
+//		window.swapBuffers();
+//		GLObjectPool::get().collect();
+class GLObjectPool {
+
+public:
+	enum class Kind {
+		Shader,
+		Program,
+		VertexArray,
+		Buffer,
+		Texture,
+		COUNT
+	};
+
+	static const size_t POOL_SIZE = 64;
+
+	static GLObjectPool& get();
+
+	GLObjectPool();
+
+	// Shared by every handle on the one context, so never copied
+	GLObjectPool(const GLObjectPool&) = delete;
+	GLObjectPool operator=(const GLObjectPool&) = delete;
+
+	// A new name of a kind that can be made in bulk (vertex array, buffer
+	// or texture, the last a GL_TEXTURE_2D with direct state access)
+	GLuint allocate(Kind kind);
+
+	// Deletes name once the GPU is done with it. 0 is ignored.
+	void release(Kind kind, GLuint name);
+
+	// Fences what was released since the last call and deletes whatever
+	// the GPU has finished with. Never waits.
+	void collect();
+
+	// Names released but not deleted yet
+	size_t pending() const;
+
+private:
+	static const size_t KINDS = static_cast<size_t>(Kind::COUNT);
+
+	// Names released before fence was put in
+	struct Retired {
+		GLsync fence;
+		std::vector<GLuint> names[KINDS];
+	};
+
+	std::vector<GLuint> pools[KINDS];
+	std::vector<GLuint> released[KINDS];
+	std::vector<Retired> retired;	// oldest first
+
+	void refill(Kind kind);
+	static void destroy(Kind kind, const std::vector<GLuint>& names);
+};
+
+
 
 // An RAII class for managing a Shader GLuint for OpenGL.
 //
@@ -155,7 +234,8 @@ private:
 
 };
 
-// An RAII class for managing a VertexBuffer GLuint for OpenGL.
+// An RAII class for managing a Texture GLuint for OpenGL. With direct state
+// access the texture is created as a GL_TEXTURE_2D.
 class TextureHandle {
 
 public:
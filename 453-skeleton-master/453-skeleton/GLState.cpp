@@ -0,0 +1,163 @@
+#include "GLState.h"
+
+#include "RenderStats.h"
+
+
+const GLenum GLState::TRACKED[GLState::CAPABILITIES] = {
+	GL_BLEND,
+	GL_DEPTH_TEST,
+	GL_FRAMEBUFFER_SRGB,
+	GL_RASTERIZER_DISCARD
+};
+
+
+GLState& GLState::get() {
+	static GLState state;
+	return state;
+}
+
+
+GLState::GLState()
+	: directStateAccessAllowed(true)
+	, directStateAccessChecked(false)
+	, directStateAccessSupported(false)
+{
+	invalidate();
+}
+
+
+void GLState::useProgram(GLuint program_) {
+	if (!count(!programKnown || program != program_)) return;
+
+	programKnown = true;
+	program = program_;
+	glUseProgram(program_);
+}
+
+
+void GLState::bindVertexArray(GLuint vao_) {
+	if (!count(!vaoKnown || vao != vao_)) return;
+
+	vaoKnown = true;
+	vao = vao_;
+	glBindVertexArray(vao_);
+}
+
+
+void GLState::bindTexture(GLuint texture_) {
+	if (!count(!textureKnown || texture != texture_)) return;
+
+	textureKnown = true;
+	texture = texture_;
+	glBindTexture(GL_TEXTURE_2D, texture_);
+}
+
+
+void GLState::setEnabled(GLenum capability, bool enabled) {
+	// Untracked capabilities always count as changed
+	Known wanted = enabled ? Known::Enabled : Known::Disabled;
+	size_t i = 0;
+	while (i < CAPABILITIES && TRACKED[i] != capability) i++;
+	if (!count(i == CAPABILITIES || capabilities[i] != wanted)) return;
+
+	if (i < CAPABILITIES) capabilities[i] = wanted;
+	if (enabled) glEnable(capability);
+	else glDisable(capability);
+}
+
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+	if (!count(!blendKnown || blendSource != source || blendDestination != destination)) return;
+
+	blendKnown = true;
+	blendSource = source;
+	blendDestination = destination;
+	glBlendFunc(source, destination);
+}
+
+
+void GLState::uniform(GLuint program_, const char* name, float x) {
+	RenderStats::get().uniformUpdates++;
+	glUniform1f(glGetUniformLocation(program_, name), x);
+}
+
+
+void GLState::uniform(GLuint program_, const char* name, GLint x) {
+	RenderStats::get().uniformUpdates++;
+	glUniform1i(glGetUniformLocation(program_, name), x);
+}
+
+
+void GLState::uniform(GLuint program_, const char* name, GLuint x) {
+	RenderStats::get().uniformUpdates++;
+	glUniform1ui(glGetUniformLocation(program_, name), x);
+}
+
+
+void GLState::uniform(GLuint program_, const char* name, glm::vec2 v) {
+	RenderStats::get().uniformUpdates++;
+	glUniform2f(glGetUniformLocation(program_, name), v.x, v.y);
+}
+
+
+void GLState::uniform(GLuint program_, const char* name, const glm::vec4* v, GLsizei count_) {
+	RenderStats::get().uniformUpdates++;
+	glUniform4fv(glGetUniformLocation(program_, name), count_, &v->x);
+}
+
+
+void GLState::uniform(GLuint program_, const char* name, const glm::ivec2* v, GLsizei count_) {
+	RenderStats::get().uniformUpdates++;
+	glUniform2iv(glGetUniformLocation(program_, name), count_, &v->x);
+}
+
+
+void GLState::forgetProgram(GLuint program_) {
+	if (program_ != 0 && program == program_) programKnown = false;
+}
+
+
+void GLState::forgetVertexArray(GLuint vao_) {
+	if (vao_ != 0 && vao == vao_) vaoKnown = false;
+}
+
+
+void GLState::forgetTexture(GLuint texture_) {
+	if (texture_ != 0 && texture == texture_) textureKnown = false;
+}
+
+
+void GLState::invalidate() {
+	programKnown = false;
+	vaoKnown = false;
+	textureKnown = false;
+	blendKnown = false;
+	program = 0;
+	vao = 0;
+	texture = 0;
+	blendSource = GL_ONE;
+	blendDestination = GL_ZERO;
+	for (Known& capability : capabilities) capability = Known::Unknown;
+}
+
+
+bool GLState::hasDirectStateAccess() {
+	if (!directStateAccessChecked) {
+		directStateAccessChecked = true;
+		// Without 4.5, the extension only provides the storage and vertex
+		// format functions we use when the extensions they come from are
+		// there too; GLEW leaves them null otherwise
+		directStateAccessSupported = GLEW_VERSION_4_5
+			|| (GLEW_ARB_direct_state_access && GLEW_ARB_buffer_storage
+				&& GLEW_ARB_texture_storage && GLEW_ARB_vertex_attrib_binding);
+	}
+	return directStateAccessAllowed && directStateAccessSupported;
+}
+
+
+bool GLState::count(bool changed) {
+	RenderStats& stats = RenderStats::get();
+	if (changed) stats.stateChanges++;
+	else stats.redundantStateChanges++;
+	return changed;
+}
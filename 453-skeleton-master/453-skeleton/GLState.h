@@ -0,0 +1,111 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A cache of the OpenGL state that the renderer changes every frame.
+//
+// Remembers the bound program, vertex array and 2D texture, which
+// capabilities are enabled and the blend function, and skips the GL call
+// when asked to set something to the value it already has. Every call that
+// does reach GL counts as a state change in RenderStats, and every call that
+// was skipped as a redundant one. The uniform setters don't cache anything,
+// they only count uniform updates.
+//
+// The cache only works if every change goes through it. ShaderProgram,
+// ComputeProgram, VertexArray and Texture already do; anything that sets
+// state behind its back (ImGui, for one) must call invalidate() afterwards so
+// the next change of each kind goes to GL again. The GL handles tell the
+// cache when a name they own is deleted, since GL may hand it out again.
+//
+// It also knows whether the context has GL 4.5 direct state access. Where it
+// does, the GL handles create their objects with glCreate* and VertexBuffer,
+// VertexArray and Texture edit them by name, without binding anything.
+//
+// Example:
+//		GLState& gl = GLState::get();
+//		gl.useProgram(program);
+//		gl.enable(GL_BLEND);
+//		gl.uniform(program, "size", 0.02f);
+//------------------------------------------------------------------------------
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+
+class GLState {
+
+public:
+	static GLState& get();
+
+	GLState();
+
+	// Shared by everything drawing on the one context, so never copied
+	GLState(const GLState&) = delete;
+	GLState operator=(const GLState&) = delete;
+
+	// Public interface
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vao);
+	void bindTexture(GLuint texture);	// GL_TEXTURE_2D on the active unit
+
+	void enable(GLenum capability) { setEnabled(capability, true); }
+	void disable(GLenum capability) { setEnabled(capability, false); }
+	void setEnabled(GLenum capability, bool enabled);
+	void blendFunc(GLenum source, GLenum destination);
+
+	// Counted uniform updates on the program currently in use
+	void uniform(GLuint program, const char* name, float x);
+	void uniform(GLuint program, const char* name, GLint x);
+	void uniform(GLuint program, const char* name, GLuint x);
+	void uniform(GLuint program, const char* name, glm::vec2 v);
+	void uniform(GLuint program, const char* name, const glm::vec4* v, GLsizei count);
+	void uniform(GLuint program, const char* name, const glm::ivec2* v, GLsizei count);
+
+	// Called when a name is deleted, so a new object given the same name
+	// isn't mistaken for the one that is bound
+	void forgetProgram(GLuint program);
+	void forgetVertexArray(GLuint vao);
+	void forgetTexture(GLuint texture);
+
+	// Forgets everything, so the next change of each kind reaches GL
+	void invalidate();
+
+	// Whether objects are created and edited with direct state access.
+	// Checked once, the first time it is asked, so a context must be
+	// current by then.
+	bool hasDirectStateAccess();
+
+	// Turns direct state access off even where it is supported, e.g. to
+	// compare the two paths. Call it before creating any GL objects.
+	void allowDirectStateAccess(bool allowed) { directStateAccessAllowed = allowed; }
+
+private:
+	// Capabilities the cache tracks. Anything else goes straight to GL.
+	static const size_t CAPABILITIES = 4;
+	static const GLenum TRACKED[CAPABILITIES];
+
+	enum class Known : unsigned char {
+		Unknown,
+		Disabled,
+		Enabled
+	};
+
+	bool programKnown;
+	bool vaoKnown;
+	bool textureKnown;
+	bool blendKnown;
+	GLuint program;
+	GLuint vao;
+	GLuint texture;
+	GLenum blendSource;
+	GLenum blendDestination;
+	Known capabilities[CAPABILITIES];
+
+	bool directStateAccessAllowed;
+	bool directStateAccessChecked;
+	bool directStateAccessSupported;
+
+	// Bumps the state change counters; returns changed
+	bool count(bool changed);
+};
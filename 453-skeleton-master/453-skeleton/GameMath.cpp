@@ -0,0 +1,184 @@
+#include "GameMath.h"
+
+#include <cmath>
+
+
+/*
+
+This function will return a unit vector of the same direction as the vector vector_in it takes as input. Does so by finding the magnitude of the input vector and dividing the x and y values by the reciprocal of this. We ignore the z because as a 2d vector we already know it to be 0.
+
+*/
+glm::vec3 makeUnitVector(glm::vec3 vector_in)
+{
+    float magnitude = sqrt(vector_in.x * vector_in.x + vector_in.y * vector_in.y);
+    return glm::vec3((vector_in.x / magnitude),(vector_in.y / magnitude), 0.0f);
+}
+
+/*
+
+Finds which way is from position towards target, as a unit vector. Clicking right on top of the ship has no direction, so in that case we keep facing whichever way we were (fallback).
+
+*/
+glm::vec2 directionToward(glm::vec2 target, glm::vec2 position, glm::vec2 fallback)
+{
+    glm::vec2 offset = target - position;
+    float magnitude = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+    if (magnitude == 0.0f) return fallback;
+    return offset / magnitude;
+}
+
+/*
+
+A rotation by theta clockwise from straight up takes the up vector (0, 1) to (sin theta, cos theta). So a ship facing direction is rotated by the theta whose cos is direction.y and whose sin is direction.x, and we can store that pair instead of the angle.
+
+*/
+glm::vec2 rotationFacing(glm::vec2 direction)
+{
+    return glm::vec2(direction.y, direction.x);
+}
+
+/*
+
+Rotates towards target one step at a time, which creates the animation type effect of the rotation. The dot product of the two rotations is the cos of the angle left to turn, and the cross product is its sin, which tells us whether to go clockwise or anticlockwise. Multiplying by step (as complex numbers) turns by exactly the step angle. Once the angle left is smaller than a step we snap to the target.
+
+*/
+glm::vec2 turnToward(glm::vec2 rotation, glm::vec2 target, glm::vec2 step)
+{
+    float dot = rotation.x * target.x + rotation.y * target.y;
+    float cross = rotation.x * target.y - rotation.y * target.x;
+    if (dot >= step.x) return target;
+
+    float s = cross < 0.0f ? -step.y : step.y;
+    glm::vec2 turned(rotation.x * step.x - rotation.y * s, rotation.y * step.x + rotation.x * s);
+
+    // Rounding makes the length drift a little every step. One Newton step
+    // towards 1 / length puts it back without a sqrt.
+    float length_squared = turned.x * turned.x + turned.y * turned.y;
+    return turned * (1.5f - 0.5f * length_squared);
+}
+
+/*
+
+Is used to move our ship along a particular direction vector by a magnitude decided by us. By multiplying the magnitude by the unit direction vector we have moved along the vector by a certain amount of units. This is then added or subtracted to the positions of the ship to produce forward and backward movement respectively.
+
+*/
+std::tuple<float, float> moveShip(glm::vec3 direction)
+{
+    float magnitude = 0.005f;
+    return std::tuple<float, float>{direction.x * magnitude, direction.y * magnitude};
+}
+
+/*
+
+Finds the distance between two points by forming a vector between them and working out the magnitude of said vector.
+
+*/
+float distanceBetween(glm::vec2 a, glm::vec2 b)
+{
+    float x = b.x - a.x;
+    float y = b.y - a.y;
+    float magnitude = sqrt(x * x + y * y);
+    return magnitude;
+}
+
+/*
+
+Diamonds start near the corners of the screen, the ship near the middle. Each diamond goes to the next corner in turn and is then jittered by up to a sixth of a unit either way, which still keeps it on screen. All the x jitter is drawn before all the y jitter, in bulk, which takes about 2 ms for a million diamonds.
+
+*/
+void scatterDiamonds(Rng& rng, float* x, float* y, size_t count)
+{
+    const glm::vec2 corners[4] = {
+        { -0.7f,  0.7f },
+        {  0.7f,  0.7f },
+        { -0.7f, -0.7f },
+        {  0.7f, -0.7f }
+    };
+
+    rng.fillUniform(x, count, -1.0f / 6, 1.0f / 6);
+    rng.fillUniform(y, count, -1.0f / 6, 1.0f / 6);
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec2 corner = corners[i % 4];
+        x[i] = corner.x - glm::sign(corner.x) * x[i];
+        y[i] = corner.y - glm::sign(corner.y) * y[i];
+    }
+}
+
+/*
+
+Checks whether two objects in our game are close enough to one another. The enough being decided to be ORBIT_RADIUS (0.25) units.
+
+*/
+bool withinOrbit(glm::vec2 ship, glm::vec2 diamond)
+{
+    // Comparing squared distances gives the same answer without the sqrt.
+    float x = diamond.x - ship.x;
+    float y = diamond.y - ship.y;
+    if (x * x + y * y < ORBIT_RADIUS * ORBIT_RADIUS) return true;
+    return false;
+}
+
+
+//------------------------------------------------------------------------------
+// Batched variants. Same results as the scalar functions above, but over
+// arrays of x and y coordinates so the loops can be vectorized.
+//------------------------------------------------------------------------------
+
+void makeUnitVectors(float* x, float* y, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float magnitude = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+        x[i] = x[i] / magnitude;
+        y[i] = y[i] / magnitude;
+    }
+}
+
+void distancesBetween(glm::vec2 a, const float* x, const float* y, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float dx = x[i] - a.x;
+        float dy = y[i] - a.y;
+        out[i] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+size_t withinOrbits(glm::vec2 ship, const float* x, const float* y, uint8_t* hits, size_t count)
+{
+    // Comparing squared distances gives the same answer without the sqrt.
+    const float radius_squared = ORBIT_RADIUS * ORBIT_RADIUS;
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        float dx = x[i] - ship.x;
+        float dy = y[i] - ship.y;
+        hits[i] = (dx * dx + dy * dy) < radius_squared;
+        total += hits[i];
+    }
+    return total;
+}
+
+size_t turnTowards(float* c, float* s, const float* targetC, const float* targetS, size_t count, glm::vec2 step)
+{
+    size_t changed = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        float dot = c[i] * targetC[i] + s[i] * targetS[i];
+        float cross = c[i] * targetS[i] - s[i] * targetC[i];
+        float sign_step = cross < 0.0f ? -step.y : step.y;
+
+        float turned_c = c[i] * step.x - s[i] * sign_step;
+        float turned_s = s[i] * step.x + c[i] * sign_step;
+        float correction = 1.5f - 0.5f * (turned_c * turned_c + turned_s * turned_s);
+
+        bool snap = dot >= step.x;
+        float new_c = snap ? targetC[i] : turned_c * correction;
+        float new_s = snap ? targetS[i] : turned_s * correction;
+        changed += (new_c != c[i]) | (new_s != s[i]);
+        c[i] = new_c;
+        s[i] = new_s;
+    }
+    return changed;
+}
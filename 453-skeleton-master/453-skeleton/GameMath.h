@@ -0,0 +1,87 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Gameplay math helpers: ship orientation and movement, and the distance
+// checks used to collect diamonds. Random numbers come from Random.h.
+//
+// These used to live in main.cpp. They only depend on glm so they can be
+// linked into the benchmarks (see perf/) without a window or GL context.
+//------------------------------------------------------------------------------
+
+#include "Random.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+
+// Distance under which the ship collects a diamond
+constexpr float ORBIT_RADIUS = 0.25f;
+
+// Starting size of every sprite
+constexpr float DEFAULT_SCALE = 0.125f;
+
+// cos and sin of the 0.05 radians things turn by each tick. Written out
+// rather than computed so every platform's libm agrees on them.
+const glm::vec2 TURN_STEP(0.99875026f, 0.04997917f);
+
+// How many ticks the ship takes to glide to where a move puts it, things
+// take to pop in when spawned, and the ship takes to grow when it collects
+// a diamond
+constexpr int MOVE_TICKS = 4;
+constexpr int SPAWN_TICKS = 30;
+constexpr int GROW_TICKS = 12;
+
+// How much bigger the ship gets for each diamond it collects
+constexpr float GROW_FACTOR = 1.05f;
+
+// Growth compounds with every diamond; with thousands of them it would
+// overflow. Twice the screen is plenty.
+constexpr float MAX_SHIP_SCALE = 2.0f;
+
+// Unit vector in the xy plane in the direction of vector_in
+glm::vec3 makeUnitVector(glm::vec3 vector_in);
+
+// Unit vector pointing from position to target, or fallback if the two
+// are the same point
+glm::vec2 directionToward(glm::vec2 target, glm::vec2 position, glm::vec2 fallback);
+
+// Rotations are kept as unit complex numbers (cos theta, sin theta), theta
+// measured clockwise from straight up, which is what sprite.vert multiplies
+// by. Facing direction d is the rotation (d.y, d.x), so turning to face a
+// point needs no trig at all.
+glm::vec2 rotationFacing(glm::vec2 direction);
+
+// Turns rotation towards target by the angle whose (cos, sin) is step, the
+// short way round, or all the way if target is closer than that
+glm::vec2 turnToward(glm::vec2 rotation, glm::vec2 target, glm::vec2 step);
+
+// Offset to move a ship one step along direction
+std::tuple<float, float> moveShip(glm::vec3 direction);
+
+float distanceBetween(glm::vec2 a, glm::vec2 b);
+
+// Writes count diamond starting positions to x and y, jittered around the
+// corners of the screen, drawing from rng
+void scatterDiamonds(Rng& rng, float* x, float* y, size_t count);
+
+// Whether diamond is within ORBIT_RADIUS of ship
+bool withinOrbit(glm::vec2 ship, glm::vec2 diamond);
+
+
+// Batched variants over arrays of x and y coordinates
+
+// Normalizes each (x[i], y[i]) in place
+void makeUnitVectors(float* x, float* y, size_t count);
+
+// out[i] = distanceBetween(a, (x[i], y[i]))
+void distancesBetween(glm::vec2 a, const float* x, const float* y, float* out, size_t count);
+
+// hits[i] = withinOrbit(ship, (x[i], y[i])). Returns the number of hits.
+size_t withinOrbits(glm::vec2 ship, const float* x, const float* y, uint8_t* hits, size_t count);
+
+// (c[i], s[i]) = turnToward((c[i], s[i]), (targetC[i], targetS[i]), step).
+// Returns the number of rotations that changed.
+size_t turnTowards(float* c, float* s, const float* targetC, const float* targetS, size_t count, glm::vec2 step);
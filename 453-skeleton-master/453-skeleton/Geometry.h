@@ -8,10 +8,13 @@
 
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "VertexLayout.h"
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 
 
@@ -22,23 +25,88 @@ struct CPU_Geometry {
 };
 
 
-// VAO and two VBOs for storing vertices and texture coordinates, respectively
-class GPU_Geometry {
+// A VAO and the buffers for vertices of a VertexLayout, e.g.
+// Mesh<VertexLayout<Position3f, Normal3f, TexCoord2f>>. The attribute setup
+// comes from the layout, so a new kind of mesh needs no GL code of its own.
+template <typename Layout, VertexStorage Storage = VertexStorage::Interleaved>
+class Mesh;
+
+template <typename... Attributes, VertexStorage Storage>
+class Mesh<VertexLayout<Attributes...>, Storage> {
 
 public:
-	GPU_Geometry();
+	using Layout = VertexLayout<Attributes...>;
+
+	Mesh()
+		: vao()
+		, buffers()
+		, interleaved()
+		, count(0)
+	{
+		if constexpr (Storage == VertexStorage::Interleaved) {
+			buffers.emplace_back(vao, Layout::interleaved());
+			return;
+		}
+
+		buffers.reserve(Layout::COUNT);
+		for (size_t i = 0; i < Layout::COUNT; i++) buffers.emplace_back(vao, Layout::separate(i));
+	}
+
+	// Because we're using the handles to do RAII for us
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
 
 	// Public interface
 	void bind() { vao.bind(); }
 
-	void setVerts(const std::vector<glm::vec3>& verts);
-	void setTexCoords(const std::vector<glm::vec2>& texCoords);
+	// One stream per attribute of the layout, in order, all the same length
+	void upload(const std::vector<typename Attributes::Value>&... streams) {
+		if constexpr (Storage == VertexStorage::Interleaved) {
+			Layout::interleave(interleaved, streams...);
+			buffers[0].uploadData(static_cast<GLsizeiptr>(interleaved.size()), interleaved.data(), GL_STATIC_DRAW);
+			count = interleaved.size() / Layout::STRIDE;
+			return;
+		}
+
+		size_t i = 0;
+		(uploadStream(buffers[i++], streams), ...);
+		count = std::min({ streams.size()... });
+	}
+
+	size_t getVertexCount() const { return count; }
 
 private:
-	// note: due to how OpenGL works, vao needs to be 
+	// note: due to how OpenGL works, vao needs to be
 	// defined and initialized before the vertex buffers
 	VertexArray vao;
 
-	VertexBuffer vertBuffer;
-	VertexBuffer texCoordBuffer;
+	std::vector<VertexBuffer> buffers;
+	std::vector<unsigned char> interleaved;		// kept so uploads don't allocate
+	size_t count;
+
+	template <typename T>
+	static void uploadStream(VertexBuffer& buffer, const std::vector<T>& stream) {
+		buffer.uploadData(static_cast<GLsizeiptr>(sizeof(T) * stream.size()), stream.data(), GL_STATIC_DRAW);
+	}
+};
+
+
+// Positions at location 0 and texture coordinates at location 1, interleaved
+// in one buffer
+class GPU_Geometry {
+
+public:
+	GPU_Geometry();
+
+	// Public interface
+	void bind() { mesh.bind(); }
+
+	// verts and texCoords must be the same length
+	void set(const CPU_Geometry& geometry);
+
+	size_t getVertexCount() const { return mesh.getVertexCount(); }
+
+private:
+	Mesh<VertexLayout<Position3f, TexCoord2f>> mesh;
 };
@@ -0,0 +1,294 @@
+#include "GpuSimulation.h"
+
+#include "GameMath.h"
+#include "GLState.h"
+#include "Log.h"
+#include "TweenSystem.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+
+namespace {
+
+	// Layouts of the std430 structs in the compute shaders
+	struct GpuShip {
+		glm::vec2 position;
+		glm::vec2 target;
+		glm::vec2 moveFrom;
+		glm::vec2 rotation;
+		glm::vec2 direction;
+		float moveProgress;
+		float scale;
+		float growFrom;
+		float growTo;
+		float growProgress;
+		float growStep;
+		uint32_t counted;
+		uint32_t pad;
+	};
+	static_assert(sizeof(GpuShip) == 72, "GpuShip must match Ship in gpu_ship.comp");
+
+	struct GpuDiamond {
+		glm::vec2 position;
+		glm::vec2 rotation;
+		glm::vec2 direction;
+		uint32_t alive;
+		uint32_t pad;
+	};
+	static_assert(sizeof(GpuDiamond) == 32, "GpuDiamond must match Diamond in gpu_diamonds.comp");
+
+	// Storage buffer bindings used by both shaders
+	const GLuint SHIP_BINDING = 0;
+	const GLuint DIAMONDS_BINDING = 1;
+	const GLuint SHIP_INSTANCE_BINDING = 2;
+	const GLuint DIAMOND_INSTANCES_BINDING = 3;
+	const GLuint COLLECTED_BINDING = 0;
+
+	// local_size_x of gpu_diamonds.comp
+	const size_t DIAMOND_GROUP_SIZE = 256;
+
+	// Diamonds uploaded per glBufferSubData() by reset(), so huge scenes
+	// don't need a second copy of every diamond in memory
+	const size_t UPLOAD_CHUNK = 65536;
+}
+
+
+GpuSimulation::GpuSimulation(int diamondCount, uint32_t seed)
+	: shipProgram("shaders/gpu_ship.comp")
+	, diamondProgram("shaders/gpu_diamonds.comp")
+	, ship()
+	, diamonds()
+	, shipInstance()
+	, diamondInstances()
+	, collected()
+	, readback()
+	, fences()
+	, nextReadback(0)
+	, random(seed)
+	, diamondCount(std::max(diamondCount, 1))
+	, score(0)
+	, tick(0)
+	, forwardHeld(false)
+	, backwardHeld(false)
+	, forwardTapped(false)
+	, backwardTapped(false)
+	, turn(false)
+	, turnTarget(0.0f)
+{
+	size_t n = getDiamondCount();
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ship);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuShip), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, diamonds);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuDiamond) * n, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, shipInstance);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::vec4), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, diamondInstances);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::vec4) * n, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, collected);
+	glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+
+	for (int k = 0; k < READBACKS; k++) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, readback[k]);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	reset();
+	Log::info("GPU_SIMULATION {} diamonds in {:.1f} MB of storage buffers", n, (sizeof(GpuDiamond) + sizeof(glm::vec4)) * n / (1024.0 * 1024.0));
+}
+
+
+GpuSimulation::~GpuSimulation() {
+	dropReadbacks();
+}
+
+
+void GpuSimulation::reset() {
+	size_t n = getDiamondCount();
+	Rng& rng = random.get(RandomStream::Spawning);
+
+	// Same draws in the same order as Simulation::reset(), so a seed starts
+	// the same layout on either
+	std::vector<float> x(n);
+	std::vector<float> y(n);
+	scatterDiamonds(rng, x.data(), y.data(), n);
+	float shipX = rng.uniform(-0.5f, 0.5f);
+	float shipY = rng.uniform(-0.5f, 0.5f);
+
+	std::vector<GpuDiamond> chunk;
+	chunk.reserve(std::min(n, UPLOAD_CHUNK));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, diamonds);
+	for (size_t begin = 0; begin < n; begin += UPLOAD_CHUNK) {
+		size_t end = std::min(begin + UPLOAD_CHUNK, n);
+		chunk.clear();
+		for (size_t i = begin; i < end; i++) {
+			chunk.push_back(GpuDiamond{ glm::vec2(x[i], y[i]), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f), 1, 0 });
+		}
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuDiamond) * begin, sizeof(GpuDiamond) * chunk.size(), chunk.data());
+	}
+
+	// Pops in from nothing, like everything in Simulation
+	GpuShip start;
+	start.position = glm::vec2(shipX, shipY);
+	start.target = start.position;
+	start.moveFrom = start.position;
+	start.rotation = glm::vec2(1.0f, 0.0f);
+	start.direction = glm::vec2(0.0f, 1.0f);
+	start.moveProgress = 1.0f;
+	start.scale = 0.0f;
+	start.growFrom = 0.0f;
+	start.growTo = DEFAULT_SCALE;
+	start.growProgress = 0.0f;
+	start.growStep = 1.0f / SPAWN_TICKS;
+	start.counted = 0;
+	start.pad = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ship);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GpuShip), &start);
+
+	// Nothing is drawn until the first tick writes the instances
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, diamondInstances);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_RGBA32F, GL_RGBA, GL_FLOAT, nullptr);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, shipInstance);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_RGBA32F, GL_RGBA, GL_FLOAT, nullptr);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	GLuint zero = 0;
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, collected);
+	glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(zero), &zero);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+
+	// Scores still on their way belong to the old game
+	dropReadbacks();
+	score = 0;
+	tick = 0;
+}
+
+
+void GpuSimulation::handleInput(const InputEvent& event) {
+	switch (event.type) {
+	case InputEventType::TurnToward:
+		turn = true;
+		turnTarget = event.position;
+		break;
+	case InputEventType::ForwardPressed:
+		forwardHeld = true;
+		forwardTapped = true;
+		break;
+	case InputEventType::ForwardReleased:
+		forwardHeld = false;
+		break;
+	case InputEventType::BackwardPressed:
+		backwardHeld = true;
+		backwardTapped = true;
+		break;
+	case InputEventType::BackwardReleased:
+		backwardHeld = false;
+		break;
+	case InputEventType::Reset:
+		reset();
+		break;
+	}
+}
+
+
+void GpuSimulation::update() {
+	pollScore();
+	tick++;
+
+	int move = 0;
+	if (forwardHeld || forwardTapped) move++;
+	if (backwardHeld || backwardTapped) move--;
+	forwardTapped = false;
+	backwardTapped = false;
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SHIP_BINDING, ship);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DIAMONDS_BINDING, diamonds);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SHIP_INSTANCE_BINDING, shipInstance);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DIAMOND_INSTANCES_BINDING, diamondInstances);
+	glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, COLLECTED_BINDING, collected);
+
+	GLState& gl = GLState::get();
+	GLuint program = shipProgram.getID();
+	shipProgram.use();
+	gl.uniform(program, "move", move);
+	gl.uniform(program, "turn", turn ? 1 : 0);
+	gl.uniform(program, "turnTarget", turnTarget);
+	gl.uniform(program, "turnStep", TURN_STEP);
+	gl.uniform(program, "moveDistance", std::get<0>(moveShip(glm::vec3(1.0f, 0.0f, 0.0f))));
+	gl.uniform(program, "moveStep", 1.0f / MOVE_TICKS);
+	gl.uniform(program, "growStep", 1.0f / GROW_TICKS);
+	gl.uniform(program, "growFactor", GROW_FACTOR);
+	gl.uniform(program, "maxScale", MAX_SHIP_SCALE);
+	shipProgram.dispatch(1, 1);
+	turn = false;
+
+	// The diamonds need to see where the ship went
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	// Every diamond pops in at the same time, so their scale is one number
+	float spawned = std::min(static_cast<float>(tick) / SPAWN_TICKS, 1.0f);
+	program = diamondProgram.getID();
+	diamondProgram.use();
+	gl.uniform(program, "count", static_cast<GLuint>(diamondCount));
+	gl.uniform(program, "turnStep", TURN_STEP);
+	gl.uniform(program, "orbitRadius", ORBIT_RADIUS);
+	gl.uniform(program, "scale", DEFAULT_SCALE * ease(EaseCurve::BackOut, spawned));
+	diamondProgram.dispatch(getDiamondCount(), DIAMOND_GROUP_SIZE);
+
+	// The next ship pass reads the counter, the score copy reads it too,
+	// and the sprites are drawn from the instances
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+	requestScore();
+}
+
+
+void GpuSimulation::pollScore() {
+	// nextReadback is the oldest slot once the ring is full. Later copies
+	// can't finish before earlier ones, so stop at the first one pending.
+	for (int n = 0; n < READBACKS; n++) {
+		int k = (nextReadback + n) % READBACKS;
+		if (fences[k] == nullptr) continue;
+
+		GLenum status = glClientWaitSync(fences[k], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+		GLuint count = 0;
+		glBindBuffer(GL_COPY_READ_BUFFER, readback[k]);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(count), &count);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		score = static_cast<int>(count);
+
+		glDeleteSync(fences[k]);
+		fences[k] = nullptr;
+	}
+}
+
+
+void GpuSimulation::requestScore() {
+	// Every slot still in flight: skip this tick rather than wait
+	if (fences[nextReadback] != nullptr) return;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, collected);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, readback[nextReadback]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	fences[nextReadback] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	nextReadback = (nextReadback + 1) % READBACKS;
+}
+
+
+void GpuSimulation::dropReadbacks() {
+	for (int k = 0; k < READBACKS; k++) {
+		if (fences[k] != nullptr) glDeleteSync(fences[k]);
+		fences[k] = nullptr;
+	}
+	nextReadback = 0;
+}
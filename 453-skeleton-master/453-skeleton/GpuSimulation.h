@@ -0,0 +1,115 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// An optional simulation that lives entirely on the GPU, for scenes far
+// bigger than Simulation can update every tick.
+//
+// Entities live in shader storage buffers. Each tick is two compute
+// dispatches: shaders/gpu_ship.comp applies the player's input to the ship
+// and moves, turns and grows it, then shaders/gpu_diamonds.comp turns every
+// diamond and collects the ones within orbit of the ship, counting them in
+// an atomic counter. Both passes also write the sprite instances their
+// entities are drawn with (see SpriteBatch::setInstanceBuffer()), so after
+// reset() uploads the starting positions no per-entity data crosses the bus
+// in either direction.
+//
+// The score is copied out of the counter into a small ring of buffers, each
+// behind a fence, and only read once its fence has passed. The CPU never
+// waits for the GPU, so getScore() is a few frames behind.
+//
+// The rules are Simulation's and a seed starts the same layout, but this is
+// not a bit-for-bit copy of the CPU game: the ship grows one tick after a
+// collection instead of on the same tick, results can differ between GPUs,
+// and there is no state hash, so sessions can't be replayed.
+//
+// Needs a GL 4.3 context, see Window::hasComputeShaders().
+//
+// Example:
+//		GpuSimulation simulation(diamondCount, seed);
+//		batch.setInstanceBuffer(simulation.getDiamondInstances(), simulation.getDiamondCount());
+//		simulation.handleInput(event);
+//		simulation.update();
+//------------------------------------------------------------------------------
+
+#include "ComputeProgram.h"
+#include "GLHandles.h"
+#include "InputEvent.h"
+#include "Random.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+
+class GpuSimulation {
+
+public:
+	GpuSimulation(int diamondCount, uint32_t seed);
+
+	// Owns fences, which the handles in GLHandles.h don't cover
+	~GpuSimulation();
+	GpuSimulation(const GpuSimulation&) = delete;
+	GpuSimulation& operator=(const GpuSimulation&) = delete;
+
+	// Uploads new random starting positions, like Simulation::reset()
+	void reset();
+
+	// Applies one input event on the next update()
+	void handleInput(const InputEvent& event);
+
+	// Queues one tick on the GPU. Never waits for it.
+	void update();
+
+	// The score as of a few ticks ago
+	int getScore() const { return score; }
+	bool hasWon() const { return score >= diamondCount; }
+
+	uint64_t getTick() const { return tick; }
+
+	// Buffers of SpriteInstance, rewritten every tick: one for the ship
+	// and getDiamondCount() for the diamonds (collected ones are empty)
+	GLuint getShipInstance() const { return shipInstance; }
+	GLuint getDiamondInstances() const { return diamondInstances; }
+	size_t getDiamondCount() const { return static_cast<size_t>(diamondCount); }
+
+private:
+	static const int READBACKS = 3;
+
+	ComputeProgram shipProgram;
+	ComputeProgram diamondProgram;
+
+	VertexBufferHandle ship;
+	VertexBufferHandle diamonds;
+	VertexBufferHandle shipInstance;
+	VertexBufferHandle diamondInstances;
+	VertexBufferHandle collected;
+
+	// Copies of collected waiting for the GPU; a null fence is a free slot
+	VertexBufferHandle readback[READBACKS];
+	GLsync fences[READBACKS];
+	int nextReadback;
+
+	RandomStreams random;
+	int diamondCount;
+	int score;
+	uint64_t tick;
+
+	// Input since the last update(), with the same held and tapped keys as
+	// Simulation
+	bool forwardHeld;
+	bool backwardHeld;
+	bool forwardTapped;
+	bool backwardTapped;
+	bool turn;
+	glm::vec2 turnTarget;
+
+	// Reads every score copy that has arrived, oldest first
+	void pollScore();
+
+	// Copies the counter for a later pollScore(), if a slot is free
+	void requestScore();
+
+	void dropReadbacks();
+};
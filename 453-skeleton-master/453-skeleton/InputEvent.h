@@ -0,0 +1,38 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Player input as discrete, timestamped events.
+//
+// The window callbacks translate raw GLFW input into InputEvents and push them
+// into an InputQueue; the simulation drains the queue once per tick and
+// applies the events in order. Unlike sampling flags once per frame, two
+// clicks (or a press and release) between ticks both arrive, and the
+// callbacks and the simulation can run on different threads.
+//------------------------------------------------------------------------------
+
+#include "SpscQueue.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+
+enum class InputEventType : uint8_t {
+	TurnToward,			// position is the clicked point in normalized device coordinates
+	ForwardPressed,
+	ForwardReleased,
+	BackwardPressed,
+	BackwardReleased,
+	Reset
+};
+
+
+struct InputEvent {
+	int64_t timeNs = 0;		// FlightRecorder::now() when the event happened
+	InputEventType type = InputEventType::Reset;
+	glm::vec2 position = glm::vec2(0.0f);
+};
+
+
+// Written by the thread running the GLFW callbacks, read by the simulation
+using InputQueue = SpscQueue<InputEvent>;
@@ -0,0 +1,203 @@
+#include "JobSystem.h"
+
+#include "Log.h"
+
+#include <limits>
+
+
+namespace {
+
+	const size_t NOT_A_WORKER = std::numeric_limits<size_t>::max();
+
+	// Which system and deque the current thread works for, if any
+	thread_local const JobSystem* currentSystem = nullptr;
+	thread_local size_t currentWorker = NOT_A_WORKER;
+}
+
+
+JobSystem::JobSystem(unsigned threadCount)
+	: threadCount(threadCount)
+	, workers()
+	, threads()
+	, queuedJobs(0)
+	, nextQueue(0)
+	, stopping(false)
+	, sleepMutex()
+	, wakeUp()
+{
+	if (this->threadCount == 0) {
+		this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// The thread calling wait() helps out, so it counts as one of them
+	size_t background = this->threadCount - 1;
+	for (size_t i = 0; i < background; i++) {
+		workers.push_back(std::make_unique<Worker>());
+	}
+	for (size_t i = 0; i < background; i++) {
+		threads.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+
+	Log::info("JOBS started with {} thread(s){}", this->threadCount, isInline() ? " (inline)" : "");
+}
+
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+
+void JobSystem::run(std::function<void()> work, JobCounter* counter) {
+	if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+	push(Job{ std::move(work), counter });
+}
+
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter) {
+	if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		// finish() decrements under the same lock, so the dependency either
+		// is already done here or will see this continuation.
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.pending.load(std::memory_order_acquire) != 0) {
+			dependency.continuations.push_back(JobCounter::Continuation{ std::move(work), counter });
+			return;
+		}
+	}
+	push(Job{ std::move(work), counter });
+}
+
+
+void JobSystem::wait(JobCounter& counter) {
+	while (!counter.isDone()) {
+		if (!runOne()) {
+			std::this_thread::yield();
+		}
+	}
+
+	// The last finish() may still be holding the lock; once it lets go the
+	// counter is no longer touched and the caller may destroy it.
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+
+void JobSystem::push(Job job) {
+	if (isInline()) {
+		execute(job);
+		return;
+	}
+
+	size_t queue = (currentSystem == this)
+		? currentWorker
+		: nextQueue.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+	{
+		std::lock_guard<std::mutex> lock(workers[queue]->mutex);
+		workers[queue]->jobs.push_back(std::move(job));
+	}
+
+	queuedJobs.fetch_add(1, std::memory_order_release);
+	{
+		// Taking the lock orders this with a worker checking queuedJobs
+		// right before it goes to sleep, so the wake up can't be lost
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	wakeUp.notify_one();
+}
+
+
+bool JobSystem::tryPop(size_t self, Job& job) {
+	// Own jobs first, newest first
+	if (self != NOT_A_WORKER) {
+		Worker& worker = *workers[self];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (!worker.jobs.empty()) {
+			job = std::move(worker.jobs.back());
+			worker.jobs.pop_back();
+			queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// Then steal the oldest job from someone else
+	size_t count = workers.size();
+	size_t start = (self != NOT_A_WORKER) ? self + 1 : nextQueue.load(std::memory_order_relaxed);
+	for (size_t n = 0; n < count; n++) {
+		size_t victim = (start + n) % count;
+		if (victim == self) continue;
+
+		Worker& worker = *workers[victim];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (!worker.jobs.empty()) {
+			job = std::move(worker.jobs.front());
+			worker.jobs.pop_front();
+			queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool JobSystem::runOne() {
+	if (isInline()) return false;
+
+	size_t self = (currentSystem == this) ? currentWorker : NOT_A_WORKER;
+	Job job;
+	if (!tryPop(self, job)) return false;
+
+	execute(job);
+	return true;
+}
+
+
+void JobSystem::execute(Job& job) {
+	job.work();
+	finish(job.counter);
+}
+
+
+void JobSystem::finish(JobCounter* counter) {
+	if (!counter) return;
+
+	std::vector<JobCounter::Continuation> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+		ready.swap(counter->continuations);
+	}
+
+	// The counters of continuations were already incremented by runAfter()
+	for (JobCounter::Continuation& continuation : ready) {
+		push(Job{ std::move(continuation.work), continuation.counter });
+	}
+}
+
+
+void JobSystem::workerLoop(size_t index) {
+	currentSystem = this;
+	currentWorker = index;
+
+	while (true) {
+		Job job;
+		if (tryPop(index, job)) {
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeUp.wait(lock, [this] {
+			return stopping.load() || queuedJobs.load(std::memory_order_acquire) != 0;
+		});
+		if (stopping) return;
+	}
+}
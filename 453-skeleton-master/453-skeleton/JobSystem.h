@@ -0,0 +1,167 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A small work-stealing job system.
+//
+// Every worker owns a deque of jobs. Workers push and pop their own jobs at
+// the back (newest first, which keeps caches warm) and, when they run dry,
+// steal from the front of another worker's deque (oldest first, which tends
+// to be the biggest remaining piece of work). Threads that are not workers,
+// like the main thread, spread their jobs over the deques and help run jobs
+// while they wait, so a JobSystem with N threads uses N - 1 background
+// threads plus the caller.
+//
+// A JobCounter counts unfinished jobs. Jobs can be added to a counter, waited
+// on, and scheduled to start only once another counter reaches zero, which
+// is how dependencies between jobs are expressed.
+//
+// With a thread count of 1 no threads are started and every job runs inline,
+// in submission order, on the calling thread. That makes runs reproducible
+// step for step, e.g. for debugging.
+//
+// Example:
+//		JobSystem jobs(4);
+//		jobs.parallelFor(count, 256, [&](size_t begin, size_t end) {
+//			for (size_t i = begin; i < end; i++) { ... }
+//		});
+//
+//		JobCounter first, second;
+//		jobs.run([&] { ... }, &first);
+//		jobs.runAfter(first, [&] { ... }, &second);
+//		jobs.wait(second);
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class JobSystem;
+
+
+class JobCounter {
+
+public:
+	JobCounter() : pending(0) {}
+
+	// Counters are referred to by address from queued jobs
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	struct Continuation {
+		std::function<void()> work;
+		JobCounter* counter;
+	};
+
+	std::atomic<int> pending;
+
+	// Jobs waiting for this counter to reach zero
+	std::mutex mutex;
+	std::vector<Continuation> continuations;
+};
+
+
+class JobSystem {
+
+public:
+	// 0 uses one thread per hardware thread, 1 runs every job inline
+	JobSystem(unsigned threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Queues work. If counter is given it is incremented now and
+	// decremented once the work has run. Jobs must not throw.
+	void run(std::function<void()> work, JobCounter* counter = nullptr);
+
+	// Like run(), but the work is only queued once dependency reaches zero
+	void runAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter = nullptr);
+
+	// Runs queued jobs on the calling thread until counter reaches zero
+	void wait(JobCounter& counter);
+
+	// Calls f(begin, end) over [0, count) split into chunks, and returns once
+	// all of them have run. Chunk boundaries are always multiples of grain,
+	// so e.g. a grain of 64 keeps chunks aligned to hit mask words.
+	template <typename F>
+	void parallelFor(size_t count, size_t grain, F&& f);
+
+	unsigned getThreadCount() const { return threadCount; }
+	bool isInline() const { return threadCount == 1; }
+
+private:
+	struct Job {
+		std::function<void()> work;
+		JobCounter* counter;
+	};
+
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	unsigned threadCount;
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+
+	// Idle workers sleep until queuedJobs becomes non-zero
+	std::atomic<size_t> queuedJobs;
+	std::atomic<size_t> nextQueue;
+	std::atomic<bool> stopping;
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+
+	void push(Job job);
+	bool tryPop(size_t self, Job& job);
+	bool runOne();
+	void execute(Job& job);
+	void finish(JobCounter* counter);
+	void workerLoop(size_t index);
+};
+
+
+template <typename F>
+void JobSystem::parallelFor(size_t count, size_t grain, F&& f) {
+	if (count == 0) return;
+	grain = std::max<size_t>(grain, 1);
+
+	// A few chunks per thread balances load without drowning in jobs
+	size_t maxChunks = static_cast<size_t>(threadCount) * 4;
+	size_t chunks = (count + grain - 1) / grain;
+	if (chunks > maxChunks) {
+		size_t groups = (chunks + maxChunks - 1) / maxChunks;
+		grain *= groups;
+		chunks = (count + grain - 1) / grain;
+	}
+
+	if (isInline() || chunks == 1) {
+		for (size_t begin = 0; begin < count; begin += grain) {
+			f(begin, std::min(begin + grain, count));
+		}
+		return;
+	}
+
+	JobCounter counter;
+	for (size_t c = 1; c < chunks; c++) {
+		size_t begin = c * grain;
+		size_t end = std::min(begin + grain, count);
+		run([&f, begin, end] { f(begin, end); }, &counter);
+	}
+
+	// The caller takes the first chunk itself instead of idling
+	f(0, std::min(grain, count));
+	wait(counter);
+}
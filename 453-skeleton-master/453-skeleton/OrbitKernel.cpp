@@ -0,0 +1,205 @@
+#include "OrbitKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ORBIT_KERNEL_X86 1
+#include <immintrin.h>
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+#else
+#define ORBIT_KERNEL_X86 0
+#endif
+
+// GCC and Clang only allow AVX2 intrinsics in functions compiled for AVX2.
+// Marking just those functions keeps the rest of the binary runnable on any
+// x86 CPU; MSVC allows the intrinsics anywhere.
+#if ORBIT_KERNEL_X86 && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+
+namespace {
+
+	// Builds the mask word for points [begin, end), where begin is a
+	// multiple of 64 and end - begin <= 64
+	inline uint64_t scalarWord(glm::vec2 center, float radiusSquared, const float* x, const float* y, size_t begin, size_t end) {
+		uint64_t word = 0;
+		for (size_t i = begin; i < end; i++) {
+			float dx = x[i] - center.x;
+			float dy = y[i] - center.y;
+			uint64_t hit = (dx * dx + dy * dy) < radiusSquared ? 1 : 0;
+			word |= hit << (i - begin);
+		}
+		return word;
+	}
+
+	// Scalar handling of the last partial word, shared by every implementation
+	inline size_t finishTail(glm::vec2 center, float radiusSquared, const float* x, const float* y, size_t full, size_t count, uint64_t* hits) {
+		if (full == count) return 0;
+		uint64_t word = scalarWord(center, radiusSquared, x, y, full, count);
+		hits[full / 64] = word;
+		return static_cast<size_t>(countSetBits(word));
+	}
+
+	using OrbitHitMaskFunction = size_t (*)(glm::vec2, float, const float*, const float*, size_t, uint64_t*);
+
+	OrbitHitMaskFunction selectImplementation() {
+		switch (detectSimdLevel()) {
+		case SimdLevel::AVX2: return orbitHitMaskAVX2;
+		case SimdLevel::SSE2: return orbitHitMaskSSE2;
+		case SimdLevel::Scalar: return orbitHitMaskScalar;
+		}
+		return orbitHitMaskScalar;
+	}
+}
+
+
+SimdLevel detectSimdLevel() {
+#if ORBIT_KERNEL_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	// The OS also has to save the upper halves of the ymm registers
+	bool ymmEnabled = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && ymmEnabled) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2) return SimdLevel::AVX2;
+	if (sse2) return SimdLevel::SSE2;
+	return SimdLevel::Scalar;
+#else
+	// Also checks that the OS saves the ymm registers
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+	if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+	return SimdLevel::Scalar;
+#endif
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+
+const char* simdLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Scalar: return "scalar";
+	case SimdLevel::SSE2: return "sse2";
+	case SimdLevel::AVX2: return "avx2";
+	}
+	return "unknown";
+}
+
+
+size_t orbitHitMask(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits) {
+	static const OrbitHitMaskFunction implementation = selectImplementation();
+	return implementation(center, radius, x, y, count, hits);
+}
+
+
+size_t orbitHitMaskScalar(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits) {
+	float radiusSquared = radius * radius;
+	size_t full = count / 64 * 64;
+	size_t total = 0;
+
+	for (size_t base = 0; base < full; base += 64) {
+		uint64_t word = scalarWord(center, radiusSquared, x, y, base, base + 64);
+		hits[base / 64] = word;
+		total += static_cast<size_t>(countSetBits(word));
+	}
+	return total + finishTail(center, radiusSquared, x, y, full, count, hits);
+}
+
+
+#if ORBIT_KERNEL_X86
+
+size_t orbitHitMaskSSE2(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits) {
+	float radiusSquared = radius * radius;
+	size_t full = count / 64 * 64;
+	size_t total = 0;
+
+	const __m128 cx = _mm_set1_ps(center.x);
+	const __m128 cy = _mm_set1_ps(center.y);
+	const __m128 r2 = _mm_set1_ps(radiusSquared);
+
+	for (size_t base = 0; base < full; base += 64) {
+		uint64_t word = 0;
+		// 16 points per iteration, 4 per register
+		for (size_t j = 0; j < 64; j += 16) {
+			const float* px = x + base + j;
+			const float* py = y + base + j;
+			uint64_t bits = 0;
+			for (int k = 0; k < 4; k++) {
+				__m128 dx = _mm_sub_ps(_mm_loadu_ps(px + 4 * k), cx);
+				__m128 dy = _mm_sub_ps(_mm_loadu_ps(py + 4 * k), cy);
+				__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+				bits |= static_cast<uint64_t>(_mm_movemask_ps(_mm_cmplt_ps(d2, r2))) << (4 * k);
+			}
+			word |= bits << j;
+		}
+		hits[base / 64] = word;
+		total += static_cast<size_t>(countSetBits(word));
+	}
+	return total + finishTail(center, radiusSquared, x, y, full, count, hits);
+}
+
+
+TARGET_AVX2
+size_t orbitHitMaskAVX2(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits) {
+	float radiusSquared = radius * radius;
+	size_t full = count / 64 * 64;
+	size_t total = 0;
+
+	const __m256 cx = _mm256_set1_ps(center.x);
+	const __m256 cy = _mm256_set1_ps(center.y);
+	const __m256 r2 = _mm256_set1_ps(radiusSquared);
+
+	for (size_t base = 0; base < full; base += 64) {
+		uint64_t word = 0;
+		// 16 points per iteration, 8 per register
+		for (size_t j = 0; j < 64; j += 16) {
+			const float* px = x + base + j;
+			const float* py = y + base + j;
+
+			__m256 dx0 = _mm256_sub_ps(_mm256_loadu_ps(px), cx);
+			__m256 dy0 = _mm256_sub_ps(_mm256_loadu_ps(py), cy);
+			__m256 dx1 = _mm256_sub_ps(_mm256_loadu_ps(px + 8), cx);
+			__m256 dy1 = _mm256_sub_ps(_mm256_loadu_ps(py + 8), cy);
+
+			__m256 d0 = _mm256_add_ps(_mm256_mul_ps(dx0, dx0), _mm256_mul_ps(dy0, dy0));
+			__m256 d1 = _mm256_add_ps(_mm256_mul_ps(dx1, dx1), _mm256_mul_ps(dy1, dy1));
+
+			uint64_t m0 = static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(d0, r2, _CMP_LT_OQ)));
+			uint64_t m1 = static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(d1, r2, _CMP_LT_OQ)));
+			word |= (m0 | (m1 << 8)) << j;
+		}
+		hits[base / 64] = word;
+		total += static_cast<size_t>(countSetBits(word));
+	}
+	return total + finishTail(center, radiusSquared, x, y, full, count, hits);
+}
+
+#else
+
+// Never selected on non-x86 builds, but keep the symbols so benchmarks link
+size_t orbitHitMaskSSE2(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits) {
+	return orbitHitMaskScalar(center, radius, x, y, count, hits);
+}
+
+size_t orbitHitMaskAVX2(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits) {
+	return orbitHitMaskScalar(center, radius, x, y, count, hits);
+}
+
+#endif
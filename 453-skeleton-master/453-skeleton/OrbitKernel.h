@@ -0,0 +1,97 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Vectorized "which of these points are within orbit" test.
+//
+// Tests one center against packed x and y arrays and writes one bit per
+// point: bit (i % 64) of hits[i / 64] is set when (x[i], y[i]) is strictly
+// within radius of center. Distances are compared squared, so there is no
+// sqrt and no branch per point. The AVX2 path tests 16 points per loop
+// iteration (two 8 wide registers), the SSE path 16 as four 4 wide
+// registers, and both are limited by how fast x and y can be read.
+//
+// The best implementation the CPU supports is picked at runtime with CPUID,
+// so the binary does not need to be compiled with -mavx2. Non-x86 builds
+// always use the scalar version.
+//
+// Example:
+//		std::vector<uint64_t> hits(hitMaskWords(count));
+//		orbitHitMask(ship, ORBIT_RADIUS, x, y, count, hits.data());
+//		forEachHit(hits.data(), count, [&](size_t i) { ... });
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+enum class SimdLevel {
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+// Highest level supported by both this build and the CPU it is running on
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// Number of uint64_t words needed for a mask over count points
+inline size_t hitMaskWords(size_t count) { return (count + 63) / 64; }
+
+// Fills hits (hitMaskWords(count) words) and returns the number of hits,
+// using the implementation for detectSimdLevel().
+size_t orbitHitMask(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits);
+
+// The individual implementations, for benchmarking. Calling one the CPU
+// does not support is undefined.
+size_t orbitHitMaskScalar(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits);
+size_t orbitHitMaskSSE2(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits);
+size_t orbitHitMaskAVX2(glm::vec2 center, float radius, const float* x, const float* y, size_t count, uint64_t* hits);
+
+
+// MSVC's __popcnt needs a CPU with POPCNT, which the scalar and SSE2 paths
+// must not assume, so it counts bits by hand instead
+inline int countSetBits(uint64_t word) {
+#if defined(_MSC_VER)
+	word = word - ((word >> 1) & 0x5555555555555555ull);
+	word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+	word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return static_cast<int>((word * 0x0101010101010101ull) >> 56);
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+// word must not be 0
+inline int countTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	// BSF, which every x64 CPU has
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return static_cast<int>(index);
+#elif defined(_MSC_VER)
+	// No 64 bit bit scan on 32 bit x86 or ARM: count the bits below the
+	// lowest set one
+	return countSetBits((word & (0 - word)) - 1);
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+// Calls f(i) for every set bit i of the mask, in increasing order
+template <typename F>
+void forEachHit(const uint64_t* hits, size_t count, F&& f) {
+	size_t words = hitMaskWords(count);
+	for (size_t w = 0; w < words; w++) {
+		uint64_t word = hits[w];
+		while (word != 0) {
+			f(w * 64 + static_cast<size_t>(countTrailingZeros(word)));
+			word &= word - 1;
+		}
+	}
+}
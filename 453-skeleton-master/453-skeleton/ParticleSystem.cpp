@@ -0,0 +1,266 @@
+#include "ParticleSystem.h"
+
+#include "GLState.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <cstddef>
+
+
+namespace {
+
+	// Emitters one update can start. Keep in sync with particle_update.vert.
+	const int MAX_EMITTERS = 16;
+
+	// Emitters that can wait for a later update before new ones are dropped
+	const size_t MAX_PENDING = 1024;
+
+	// How quickly particles slow down, per second, and their size at birth
+	const float DRAG = 1.5f;
+	const float PARTICLE_SIZE = 0.02f;
+
+	// Layout of one particle in the buffers, matching the outputs of
+	// particle_update.vert
+	struct Particle {
+		glm::vec4 motion;	// position.xy, velocity.xy
+		glm::vec2 ageLife;	// seconds alive, seconds it lives for
+	};
+
+	// Triangle strip over the unit quad: corner xy, texture coordinate uv
+	const glm::vec4 QUAD_CORNERS[4] = {
+		{ -1.f, -1.f, 0.f, 0.f },
+		{  1.f, -1.f, 1.f, 0.f },
+		{ -1.f,  1.f, 0.f, 1.f },
+		{  1.f,  1.f, 1.f, 1.f }
+	};
+
+	const float TWO_PI = 6.28318531f;
+
+	// Points the attributes at the particles from slot firstParticle on, in
+	// the buffer bound to GL_ARRAY_BUFFER
+	void pointParticleAttributes(GLuint first, size_t firstParticle) {
+		size_t base = firstParticle * sizeof(Particle);
+		glVertexAttribPointer(first, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)(base + offsetof(Particle, motion)));
+		glVertexAttribPointer(first + 1, 2, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)(base + offsetof(Particle, ageLife)));
+	}
+
+	void setParticleAttributes(GLuint first, GLuint divisor) {
+		pointParticleAttributes(first, 0);
+		glEnableVertexAttribArray(first);
+		glEnableVertexAttribArray(first + 1);
+		glVertexAttribDivisor(first, divisor);
+		glVertexAttribDivisor(first + 1, divisor);
+	}
+}
+
+
+ParticleEmitter makeExhaust(glm::vec2 position, glm::vec2 direction, uint32_t count) {
+	ParticleEmitter emitter;
+	emitter.position = position;
+	emitter.direction = direction;
+	emitter.spread = 0.5f;
+	emitter.speed = 0.5f;
+	emitter.speedJitter = 0.3f;
+	emitter.lifetime = 0.4f;
+	emitter.count = count;
+	return emitter;
+}
+
+
+ParticleEmitter makeExplosion(glm::vec2 position, uint32_t count) {
+	ParticleEmitter emitter;
+	emitter.position = position;
+	emitter.direction = glm::vec2(1.0f, 0.0f);
+	emitter.spread = TWO_PI;
+	emitter.speed = 0.6f;
+	emitter.speedJitter = 0.8f;
+	emitter.lifetime = 0.9f;
+	emitter.count = count;
+	return emitter;
+}
+
+
+ParticleSystem::ParticleSystem(size_t capacity, uint64_t seed)
+	: updateProgram("shaders/particle_update.vert", "shaders/particle_update.frag", { "outMotion", "outAgeLife" })
+	, drawProgram("shaders/particle.vert", "shaders/particle.frag")
+	, particles()
+	, updateVao()
+	, drawVao()
+	, quad()
+	, current(0)
+	, capacity(std::max<size_t>(capacity, 1))
+	, head(0)
+	, live()
+	, liveSlots(0)
+	, clock(0.0)
+	, idle(true)
+	, pending()
+	, random(seed, static_cast<uint64_t>(RandomStream::Effects))
+{
+	glBindBuffer(GL_ARRAY_BUFFER, quad);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_CORNERS), QUAD_CORNERS, GL_STATIC_DRAW);
+
+	GLState& gl = GLState::get();
+	for (int b = 0; b < 2; b++) {
+		// Only ever written by transform feedback and read by draws, so the
+		// contents can stay undefined until a slot is first handed out
+		glBindBuffer(GL_ARRAY_BUFFER, particles[b]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Particle) * this->capacity, nullptr, GL_DYNAMIC_COPY);
+
+		// The update reads one particle per vertex
+		gl.bindVertexArray(updateVao[b]);
+		glBindBuffer(GL_ARRAY_BUFFER, particles[b]);
+		setParticleAttributes(0, 0);
+
+		// Drawing reads quad corners per vertex and one particle per instance
+		gl.bindVertexArray(drawVao[b]);
+		glBindBuffer(GL_ARRAY_BUFFER, quad);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glEnableVertexAttribArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, particles[b]);
+		setParticleAttributes(1, 1);
+	}
+	gl.bindVertexArray(0);
+}
+
+
+void ParticleSystem::emit(const ParticleEmitter& emitter) {
+	if (emitter.count == 0 || pending.size() >= MAX_PENDING) return;
+	pending.push_back(emitter);
+}
+
+
+void ParticleSystem::update(float dt) {
+	// Hand each queued emitter the next slots of the ring, as many emitters
+	// and particles as one update can start
+	glm::vec4 origins[MAX_EMITTERS];
+	glm::vec4 shapes[MAX_EMITTERS];
+	glm::ivec2 slots[MAX_EMITTERS];
+	int emitters = 0;
+	size_t started = 0;
+	size_t first = head;
+	float lifetime = 0.0f;
+	clock += dt;
+
+	size_t taken = 0;
+	while (taken < pending.size() && emitters < MAX_EMITTERS && started < capacity) {
+		const ParticleEmitter& emitter = pending[taken++];
+		size_t count = std::min<size_t>(emitter.count, capacity - started);
+
+		origins[emitters] = glm::vec4(emitter.position, emitter.direction);
+		shapes[emitters] = glm::vec4(emitter.speed, emitter.speedJitter, emitter.spread, emitter.lifetime);
+		slots[emitters] = glm::ivec2(static_cast<int>(head), static_cast<int>(count));
+		emitters++;
+
+		head = (head + count) % capacity;
+		started += count;
+		lifetime = std::max(lifetime, emitter.lifetime);
+	}
+	pending.erase(pending.begin(), pending.begin() + taken);
+
+	if (started > 0) {
+		live.push_back({ first, started, clock + lifetime });
+		liveSlots += started;
+	}
+
+	// The window starts at the oldest batch that may still have a particle
+	// alive. A long lived batch keeps the shorter lived ones after it in
+	// the window, which only costs updating some dead particles.
+	while (!live.empty() && live.front().diesAt <= clock) {
+		liveSlots -= live.front().count;
+		live.pop_front();
+	}
+
+	// Nothing to start and everything has died: skip the GPU work entirely
+	if (live.empty()) {
+		idle = true;
+		return;
+	}
+	idle = false;
+
+	int next = 1 - current;
+	GLState& gl = GLState::get();
+	GLuint program = updateProgram.getID();
+	updateProgram.use();
+	gl.uniform(program, "dt", dt);
+	gl.uniform(program, "drag", DRAG);
+	gl.uniform(program, "seed", random.nextU32());
+	gl.uniform(program, "capacity", static_cast<GLint>(capacity));
+	gl.uniform(program, "emitterCount", emitters);
+	if (emitters > 0) {
+		gl.uniform(program, "emitterOrigin", origins, emitters);
+		gl.uniform(program, "emitterShape", shapes, emitters);
+		gl.uniform(program, "emitterSlots", slots, emitters);
+	}
+
+	// Every particle in the live window goes through the vertex shader once
+	// and comes out in the same slot of the other buffer; nothing is
+	// rasterized. Slots outside the window are dead in both buffers, and
+	// are only read again once handed out, which overwrites them.
+	size_t firsts[2];
+	size_t counts[2];
+	int ranges = liveRanges(firsts, counts);
+
+	gl.enable(GL_RASTERIZER_DISCARD);
+	gl.bindVertexArray(updateVao[current]);
+	for (int r = 0; r < ranges; r++) {
+		glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, particles[next], firsts[r] * sizeof(Particle), counts[r] * sizeof(Particle));
+		glBeginTransformFeedback(GL_POINTS);
+		glDrawArrays(GL_POINTS, static_cast<GLint>(firsts[r]), static_cast<GLsizei>(counts[r]));
+		glEndTransformFeedback();
+	}
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	gl.disable(GL_RASTERIZER_DISCARD);
+
+	current = next;
+	RenderStats::get().drawCalls += ranges;
+}
+
+
+void ParticleSystem::draw(Texture& texture) {
+	if (idle) return;
+
+	GLState& gl = GLState::get();
+	drawProgram.use();
+	gl.uniform(drawProgram.getID(), "size", PARTICLE_SIZE);
+
+	// Blending is only ever on for particles, so turning it off again is
+	// enough; the blend function can stay for the next frame
+	gl.enable(GL_BLEND);
+	gl.blendFunc(GL_SRC_ALPHA, GL_ONE);
+
+	// GL 3.3 has no base instance, so each range moves the per instance
+	// attributes to its first slot instead
+	size_t firsts[2];
+	size_t counts[2];
+	int ranges = liveRanges(firsts, counts);
+
+	RenderStats& stats = RenderStats::get();
+	gl.bindVertexArray(drawVao[current]);
+	texture.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, particles[current]);
+	for (int r = 0; r < ranges; r++) {
+		pointParticleAttributes(1, firsts[r]);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(counts[r]));
+		stats.drawCalls++;
+		stats.instances += counts[r];
+	}
+
+	gl.disable(GL_BLEND);
+}
+
+
+int ParticleSystem::liveRanges(size_t first[2], size_t count[2]) const {
+	// Once more has been handed out than fits, the whole ring is live
+	if (liveSlots >= capacity) {
+		first[0] = 0;
+		count[0] = capacity;
+		return 1;
+	}
+
+	first[0] = live.front().first;
+	count[0] = std::min(liveSlots, capacity - first[0]);
+	first[1] = 0;
+	count[1] = liveSlots - count[0];
+	return count[1] > 0 ? 2 : 1;
+}
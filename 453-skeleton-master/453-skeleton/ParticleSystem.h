@@ -0,0 +1,125 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// GPU particles for ship exhaust and collection explosions.
+//
+// Particles live only on the GPU, in two vertex buffers that take turns
+// being read and written. Each update() is one draw call with transform
+// feedback (GL 3.3): shaders/particle_update.vert reads every particle from
+// one buffer, moves, slows and ages it, and the result is captured into the
+// other. draw() then renders the new buffer as instanced textured quads with
+// additive blending.
+//
+// Spawning also happens in the update shader. Slots are handed out from a
+// ring: emit() only reserves the next `count` slots, and the shader starts a
+// new particle in every reserved slot (random directions come from hashing
+// the slot index with a per-frame seed). The CPU cost of a frame is a few
+// uniforms and two draw calls, no matter how many particles are alive. When
+// the ring wraps, the oldest particles are replaced first.
+//
+// Only the live window of the ring is updated and drawn: the slots handed
+// out since the oldest batch of particles that may still be alive. The GPU
+// cost follows how many particles are alive, not how many have ever been
+// emitted. A window that wraps past the end of the ring takes two draws.
+//
+// Nothing here is part of the simulation. Randomness comes from an Rng on
+// the effects stream, so particles never change what gameplay sees.
+//
+// Example:
+//		ParticleSystem particles(1 << 20, seed);
+//		particles.emit(makeExplosion(position, 2000));
+//		particles.update(dt);
+//		particles.draw(fireTexture);
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "Random.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+
+// Starts count particles at position, heading along direction turned by up
+// to half of spread either way
+struct ParticleEmitter {
+	glm::vec2 position = glm::vec2(0.0f);
+	glm::vec2 direction = glm::vec2(0.0f, 1.0f);	// unit length
+	float spread = 0.0f;			// radians
+	float speed = 0.0f;				// units per second
+	float speedJitter = 0.0f;		// speeds vary by up to this fraction
+	float lifetime = 1.0f;			// seconds; particles live for 50-100% of it
+	uint32_t count = 0;
+};
+
+// A narrow cone of fire out of the back of a ship
+ParticleEmitter makeExhaust(glm::vec2 position, glm::vec2 direction, uint32_t count);
+
+// Fire in every direction
+ParticleEmitter makeExplosion(glm::vec2 position, uint32_t count);
+
+
+class ParticleSystem {
+
+public:
+	ParticleSystem(size_t capacity, uint64_t seed);
+
+	// Because we're using the handles to do RAII for us
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+
+	// Queues particles to start on the next update(). Emitters past what one
+	// update can start wait for the one after.
+	void emit(const ParticleEmitter& emitter);
+
+	// Spawns the queued particles and advances every particle dt seconds
+	void update(float dt);
+
+	// Draws every live particle with texture, blended additively
+	void draw(Texture& texture);
+
+	size_t getCapacity() const { return capacity; }
+
+	// Upper bound on how many particles could still be alive
+	size_t getActive() const { return idle ? 0 : std::min(liveSlots, capacity); }
+
+private:
+	ShaderProgram updateProgram;
+	ShaderProgram drawProgram;
+
+	// Two copies of the particles; current is the one last written
+	VertexBufferHandle particles[2];
+	VertexArrayHandle updateVao[2];
+	VertexArrayHandle drawVao[2];
+	VertexBufferHandle quad;
+	int current;
+
+	// Slots handed out by one update, and when the last of their particles
+	// will have died
+	struct Span {
+		size_t first;
+		size_t count;
+		double diesAt;
+	};
+
+	size_t capacity;
+	size_t head;			// next slot to hand out
+	std::deque<Span> live;	// oldest first
+	size_t liveSlots;		// total count of live, may exceed capacity
+	double clock;			// seconds of updates so far
+	bool idle;
+
+	std::vector<ParticleEmitter> pending;
+	Rng random;
+
+	// The live window as at most two ranges of slots, [first, first + count).
+	// Returns how many.
+	int liveRanges(size_t first[2], size_t count[2]) const;
+};
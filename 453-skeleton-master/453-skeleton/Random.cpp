@@ -0,0 +1,139 @@
+#include "Random.h"
+
+#include <algorithm>
+
+
+namespace {
+
+	inline uint32_t rotl(uint32_t x, int k) {
+		return (x << k) | (x >> (32 - k));
+	}
+
+	// SplitMix64, the recommended way to expand a seed into xoshiro state
+	inline uint64_t splitMix64(uint64_t& x) {
+		uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// 24 random bits scaled to [lo, hi). The integer goes through int32_t
+	// since signed conversion is what SIMD units have instructions for.
+	inline float toUniform(uint32_t bits, float lo, float scale) {
+		return lo + static_cast<float>(static_cast<int32_t>(bits >> 8)) * scale;
+	}
+}
+
+
+Rng::Rng(uint64_t seed, uint64_t stream) {
+	this->seed(seed, stream);
+}
+
+
+void Rng::seed(uint64_t seed, uint64_t stream) {
+	// Mix the stream in before expanding, so neighbouring streams don't
+	// start from related states
+	uint64_t x = seed;
+	uint64_t s = stream;
+	x ^= splitMix64(s);
+
+	for (int word = 0; word < 4; word += 2) {
+		uint64_t v = splitMix64(x);
+		state[word] = static_cast<uint32_t>(v);
+		state[word + 1] = static_cast<uint32_t>(v >> 32);
+	}
+	for (int lane = 0; lane < LANES; lane++) {
+		for (int word = 0; word < 4; word += 2) {
+			uint64_t v = splitMix64(x);
+			lanes[word][lane] = static_cast<uint32_t>(v);
+			lanes[word + 1][lane] = static_cast<uint32_t>(v >> 32);
+		}
+	}
+}
+
+
+uint32_t Rng::nextU32() {
+	// xoshiro128**
+	uint32_t result = rotl(state[1] * 5, 7) * 9;
+	uint32_t t = state[1] << 9;
+
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = rotl(state[3], 11);
+
+	return result;
+}
+
+
+float Rng::uniform(float lo, float hi) {
+	return toUniform(nextU32(), lo, (hi - lo) * (1.0f / 16777216.0f));
+}
+
+
+uint32_t Rng::below(uint32_t bound) {
+	// Lemire's multiply and shift, rejecting the few values that would
+	// make some results more likely than others
+	uint64_t m = static_cast<uint64_t>(nextU32()) * bound;
+	uint32_t low = static_cast<uint32_t>(m);
+	if (low < bound) {
+		uint32_t threshold = (0u - bound) % bound;
+		while (low < threshold) {
+			m = static_cast<uint64_t>(nextU32()) * bound;
+			low = static_cast<uint32_t>(m);
+		}
+	}
+	return static_cast<uint32_t>(m >> 32);
+}
+
+
+void Rng::fillUniform(float* out, size_t count, float lo, float hi) {
+	const float scale = (hi - lo) * (1.0f / 16777216.0f);
+
+	// Local copies let the compiler keep the lanes in registers
+	uint32_t s0[LANES], s1[LANES], s2[LANES], s3[LANES];
+	std::copy(lanes[0], lanes[0] + LANES, s0);
+	std::copy(lanes[1], lanes[1] + LANES, s1);
+	std::copy(lanes[2], lanes[2] + LANES, s2);
+	std::copy(lanes[3], lanes[3] + LANES, s3);
+
+	float block[LANES];
+	for (size_t i = 0; i < count; i += LANES) {
+		// xoshiro128+, one step of every lane
+		for (int l = 0; l < LANES; l++) {
+			uint32_t result = s0[l] + s3[l];
+			uint32_t t = s1[l] << 9;
+
+			s2[l] ^= s0[l];
+			s3[l] ^= s1[l];
+			s1[l] ^= s2[l];
+			s0[l] ^= s3[l];
+			s2[l] ^= t;
+			s3[l] = rotl(s3[l], 11);
+
+			block[l] = toUniform(result, lo, scale);
+		}
+
+		size_t n = std::min<size_t>(LANES, count - i);
+		std::copy(block, block + n, out + i);
+	}
+
+	std::copy(s0, s0 + LANES, lanes[0]);
+	std::copy(s1, s1 + LANES, lanes[1]);
+	std::copy(s2, s2 + LANES, lanes[2]);
+	std::copy(s3, s3 + LANES, lanes[3]);
+}
+
+
+RandomStreams::RandomStreams(uint64_t seed) {
+	this->seed(seed);
+}
+
+
+void RandomStreams::seed(uint64_t seed) {
+	for (size_t i = 0; i < static_cast<size_t>(RandomStream::Count); i++) {
+		streams[i].seed(seed, i);
+	}
+}
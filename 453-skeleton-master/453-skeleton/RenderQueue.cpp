@@ -0,0 +1,207 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+namespace {
+
+	const int DEPTH_BITS = 24;
+	const int GEOMETRY_BITS = 12;
+	const int TEXTURE_BITS = 10;
+	const int SHADER_BITS = 10;
+
+	const int GEOMETRY_SHIFT = DEPTH_BITS;
+	const int TEXTURE_SHIFT = GEOMETRY_SHIFT + GEOMETRY_BITS;
+	const int SHADER_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+	const int LAYER_SHIFT = SHADER_SHIFT + SHADER_BITS;
+
+	const uint32_t MAX_DEPTH = (1u << DEPTH_BITS) - 1;
+
+	// Every sprite read from memory is drawn from the same quad and the
+	// same kind of instance buffer, which is what lets them merge
+	const uint32_t SPRITE_GEOMETRY = 0;
+
+	// Index of object in table, adding it if this frame hasn't seen it yet
+	template <typename T>
+	uint64_t idOf(std::vector<T*>& table, T* object, int bits) {
+		auto found = std::find(table.begin(), table.end(), object);
+		if (found != table.end()) return static_cast<uint64_t>(found - table.begin());
+
+		if (table.size() >= (size_t(1) << bits)) throw std::runtime_error("Too many different draw states in one frame");
+		table.push_back(object);
+		return table.size() - 1;
+	}
+}
+
+
+RenderQueue::RenderQueue()
+	: items()
+	, keys()
+	, shaders()
+	, textures()
+	, geometries(SPRITE_GEOMETRY + 1)
+	, batches()
+	, culling(false)
+	, order()
+	, sorted()
+	, keyScratch()
+	, orderScratch()
+	, runs()
+	, merged()
+{}
+
+
+void RenderQueue::submitSprites(uint8_t layer, ShaderProgram& shader, Texture& texture, const SpriteInstance* data, size_t count, float depth) {
+	if (count == 0) return;
+
+	keys.push_back(makeKey(layer, &shader, &texture, SPRITE_GEOMETRY, depth));
+	items.push_back({ &shader, &texture, data, count, 0, nullptr });
+}
+
+
+void RenderQueue::submitSpriteBuffer(uint8_t layer, ShaderProgram& shader, Texture& texture, GLuint buffer, size_t count, float depth) {
+	if (count == 0) return;
+
+	keys.push_back(makeKey(layer, &shader, &texture, geometries++, depth));
+	items.push_back({ &shader, &texture, nullptr, count, buffer, nullptr });
+}
+
+
+void RenderQueue::submitCustom(uint8_t layer, std::function<void()> draw, float depth) {
+	keys.push_back(makeKey(layer, nullptr, nullptr, geometries++, depth));
+	items.push_back({ nullptr, nullptr, nullptr, 0, 0, std::move(draw) });
+}
+
+
+void RenderQueue::enableCulling() {
+	culling = true;
+	for (auto& b : batches) b->enableCulling();
+}
+
+
+void RenderQueue::flush() {
+	if (items.empty()) return;
+	sort();
+
+	// Consecutive items whose keys only differ in depth share a draw
+	runs.clear();
+	for (size_t i = 0; i < order.size(); i++) {
+		bool sameState = i > 0 && (keys[order[i]] >> DEPTH_BITS) == (keys[order[i - 1]] >> DEPTH_BITS);
+		if (sameState) runs.back().last++;
+		else runs.push_back({ i, i + 1 });
+	}
+
+	// Upload and cull every run before drawing anything, since culling runs
+	// a compute shader and would unbind the program used to draw
+	size_t sprites = 0;
+	for (const Run& run : runs) {
+		const Item& first = items[order[run.first]];
+		if (first.draw) continue;
+
+		// Only sprites that never went through the CPU need culling here;
+		// snapshots were culled when they were taken
+		SpriteBatch& b = batch(sprites++);
+		if (first.buffer != 0) {
+			b.setInstanceBuffer(first.buffer, first.count);
+			b.cull();
+		}
+		else if (run.last - run.first == 1) {
+			b.setInstances(first.instances, first.count);
+		}
+		else {
+			merged.clear();
+			for (size_t i = run.first; i < run.last; i++) {
+				const Item& item = items[order[i]];
+				merged.insert(merged.end(), item.instances, item.instances + item.count);
+			}
+			b.setInstances(merged);
+		}
+	}
+
+	sprites = 0;
+	for (const Run& run : runs) {
+		Item& first = items[order[run.first]];
+		if (first.draw) {
+			first.draw();
+			continue;
+		}
+
+		first.shader->use();
+		batch(sprites++).draw(*first.texture);
+	}
+
+	items.clear();
+	keys.clear();
+	shaders.clear();
+	textures.clear();
+	geometries = SPRITE_GEOMETRY + 1;
+}
+
+
+uint64_t RenderQueue::makeKey(uint8_t layer, ShaderProgram* shader, Texture* texture, uint32_t geometry, float depth) {
+	if (geometry >= (1u << GEOMETRY_BITS)) throw std::runtime_error("Too many unmergeable draws in one frame");
+
+	// Custom draws bind their own program and textures, so they sort ahead
+	// of everything else in their layer
+	uint64_t shaderId = shader ? idOf(shaders, shader, SHADER_BITS) + 1 : 0;
+	uint64_t textureId = texture ? idOf(textures, texture, TEXTURE_BITS) + 1 : 0;
+	uint64_t quantized = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * MAX_DEPTH);
+
+	return (static_cast<uint64_t>(layer) << LAYER_SHIFT)
+		| (shaderId << SHADER_SHIFT)
+		| (textureId << TEXTURE_SHIFT)
+		| (static_cast<uint64_t>(geometry) << GEOMETRY_SHIFT)
+		| quantized;
+}
+
+
+void RenderQueue::sort() {
+	// Least significant digit first radix sort of (key, item) pairs, one
+	// byte per pass. All eight histograms come from a single read of the
+	// keys, and passes where every key has the same byte are skipped, which
+	// is most of them when only a few states are in use. Items with equal
+	// keys stay in submission order.
+	size_t n = keys.size();
+	order.resize(n);
+	for (size_t i = 0; i < n; i++) order[i] = static_cast<uint32_t>(i);
+	if (n < 2) return;
+
+	size_t counts[8][256] = {};
+	for (uint64_t key : keys) {
+		for (int pass = 0; pass < 8; pass++) counts[pass][(key >> (pass * 8)) & 0xFF]++;
+	}
+
+	sorted.assign(keys.begin(), keys.end());
+	keyScratch.resize(n);
+	orderScratch.resize(n);
+	for (int pass = 0; pass < 8; pass++) {
+		int shift = pass * 8;
+		size_t* count = counts[pass];
+		if (count[(sorted[0] >> shift) & 0xFF] == n) continue;
+
+		size_t offset = 0;
+		for (int digit = 0; digit < 256; digit++) {
+			size_t c = count[digit];
+			count[digit] = offset;
+			offset += c;
+		}
+		for (size_t i = 0; i < n; i++) {
+			size_t slot = count[(sorted[i] >> shift) & 0xFF]++;
+			keyScratch[slot] = sorted[i];
+			orderScratch[slot] = order[i];
+		}
+		sorted.swap(keyScratch);
+		order.swap(orderScratch);
+	}
+}
+
+
+SpriteBatch& RenderQueue::batch(size_t index) {
+	while (batches.size() <= index) {
+		batches.push_back(std::make_unique<SpriteBatch>());
+		if (culling) batches.back()->enableCulling();
+	}
+	return *batches[index];
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Collects a frame's draws and submits them in an order that keeps state
+// changes down, merging whatever can share a draw call.
+//
+// Every submitted item gets a 64-bit sort key, most significant bits first:
+//
+//		layer (8) | shader (10) | texture (10) | geometry (12) | depth (24)
+//
+// flush() radix sorts the keys, so items come out by layer first (layers are
+// drawn back to front, lowest first), then grouped by shader and texture, and
+// finally by depth within a group. Shader, texture and geometry are small ids
+// the queue hands out per frame, not GL names.
+//
+// Sprites submitted from CPU memory all share one geometry (the sprite quad),
+// so consecutive items whose keys differ only in depth are merged into a
+// single instanced draw. Sprites read from a GPU buffer and custom draws get
+// a geometry of their own and are never merged.
+//
+// Nothing is copied on submit: instance data and everything a custom draw
+// refers to must stay alive until flush().
+//
+// Example:
+//		queue.submitSprites(0, shader, diamondTexture, diamonds);
+//		queue.submitCustom(1, [&] { particles.draw(fireTexture); });
+//		queue.submitSprites(2, shader, shipTexture, ships);
+//		queue.flush();
+//------------------------------------------------------------------------------
+
+#include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "SpriteInstance.h"
+#include "Texture.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+class RenderQueue {
+
+public:
+	RenderQueue();
+
+	// Sprites read from memory. Depth is in [0, 1] and only orders items
+	// that have the same layer, shader and texture.
+	void submitSprites(uint8_t layer, ShaderProgram& shader, Texture& texture, const SpriteInstance* data, size_t count, float depth = 0.0f);
+	void submitSprites(uint8_t layer, ShaderProgram& shader, Texture& texture, const std::vector<SpriteInstance>& instances, float depth = 0.0f) {
+		submitSprites(layer, shader, texture, instances.data(), instances.size(), depth);
+	}
+
+	// Sprites already in a GPU buffer, see SpriteBatch::setInstanceBuffer()
+	void submitSpriteBuffer(uint8_t layer, ShaderProgram& shader, Texture& texture, GLuint buffer, size_t count, float depth = 0.0f);
+
+	// Anything else. draw binds whatever it needs itself.
+	void submitCustom(uint8_t layer, std::function<void()> draw, float depth = 0.0f);
+
+	// Culls sprites read from GPU buffers on the GPU, see
+	// SpriteBatch::cull(). Sprites from memory are left alone, since
+	// snapshots are already culled on the CPU. Needs compute shaders, see
+	// Window::hasComputeShaders().
+	void enableCulling();
+
+	// Sorts and draws everything submitted since the last flush(), then
+	// empties the queue
+	void flush();
+
+	size_t size() const { return items.size(); }
+
+private:
+	struct Item {
+		ShaderProgram* shader;				// null for custom draws
+		Texture* texture;
+		const SpriteInstance* instances;
+		size_t count;
+		GLuint buffer;						// 0 unless read from a GPU buffer
+		std::function<void()> draw;			// custom draws only
+	};
+
+	// A run of sorted items drawn together, items [first, last)
+	struct Run {
+		size_t first;
+		size_t last;
+	};
+
+	std::vector<Item> items;
+	std::vector<uint64_t> keys;
+
+	// Per-frame ids for the key
+	std::vector<ShaderProgram*> shaders;
+	std::vector<Texture*> textures;
+	uint32_t geometries;
+
+	// One batch per sprite run, kept between frames so their buffers are
+	// reused
+	std::vector<std::unique_ptr<SpriteBatch>> batches;
+	bool culling;
+
+	// Scratch space for flush(), kept so flushing doesn't allocate
+	std::vector<uint32_t> order;
+	std::vector<uint64_t> sorted;
+	std::vector<uint64_t> keyScratch;
+	std::vector<uint32_t> orderScratch;
+	std::vector<Run> runs;
+	std::vector<SpriteInstance> merged;
+
+	uint64_t makeKey(uint8_t layer, ShaderProgram* shader, Texture* texture, uint32_t geometry, float depth);
+	void sort();
+	SpriteBatch& batch(size_t index);
+};
@@ -0,0 +1,47 @@
+#include "RenderSnapshot.h"
+
+#include "CullKernel.h"
+#include "Simulation.h"
+
+
+namespace {
+
+	// There is no camera: the screen shows normalized device coordinates
+	const ViewRect SCREEN = { glm::vec2(-1.0f), glm::vec2(1.0f) };
+
+	// sprite.vert draws the quad from -1 to 1 scaled by the entity's
+	// scale, so its corners reach sqrt(2) * scale from the center
+	const float SPRITE_REACH = 1.41421356f;
+}
+
+
+void captureSnapshot(const Simulation& simulation, uint64_t tick, RenderSnapshot& out, std::vector<uint32_t>& visible) {
+	const EntityStore& entities = simulation.getEntities();
+
+	out.tick = tick;
+	out.score = simulation.getScore();
+	out.won = simulation.hasWon();
+
+	// Only what is on screen gets copied, uploaded and drawn
+	size_t n = entities.size();
+	visible.resize(n);
+	size_t seen = cullCircles(SCREEN, entities.x.data(), entities.y.data(), entities.scale.data(), SPRITE_REACH, n, visible.data());
+
+	out.ships.clear();
+	out.diamonds.clear();
+	for (size_t v = 0; v < seen; v++) {
+		size_t i = visible[v];
+		glm::vec2 rotation(entities.rotationCos[i], entities.rotationSin[i]);
+		SpriteInstance instance = { glm::vec2(entities.x[i], entities.y[i]), rotation * entities.scale[i] };
+		if (entities.kind[i] == EntityKind::Ship) out.ships.push_back(instance);
+		else out.diamonds.push_back(instance);
+	}
+
+	// Exhaust leaves from the back of the ship, away from where it's going
+	int thrust = simulation.getThrust();
+	size_t s = entities.indexOf(simulation.getShip());
+	glm::vec2 facing(entities.directionX[s], entities.directionY[s]);
+	out.thrusting = thrust != 0;
+	out.exhaustPosition = entities.position(s) - facing * entities.scale[s] * 0.8f;
+	out.exhaustDirection = facing * static_cast<float>(-thrust);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Everything the renderer needs to draw one simulation tick, copied out of the
+// simulation so that drawing never reads state the simulation is changing.
+//------------------------------------------------------------------------------
+
+#include "SpriteInstance.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+class Simulation;
+
+
+// A diamond collected on tick, at position
+struct ParticleBurst {
+	uint64_t tick;
+	glm::vec2 position;
+};
+
+
+struct RenderSnapshot {
+	uint64_t tick = 0;
+	int score = 0;
+	bool won = false;
+
+	std::vector<SpriteInstance> ships;
+	std::vector<SpriteInstance> diamonds;
+
+	// Where the player's exhaust comes out and which way it goes, while the
+	// ship is moving
+	bool thrusting = false;
+	glm::vec2 exhaustPosition = glm::vec2(0.0f);
+	glm::vec2 exhaustDirection = glm::vec2(0.0f, -1.0f);
+
+	// Diamonds collected in the last few ticks, not just this one, so that a
+	// renderer that skipped a snapshot still sees every collection once.
+	// Compare the ticks against the last snapshot drawn.
+	std::vector<ParticleBurst> bursts;
+};
+
+
+// Overwrites out with the current state of simulation, except bursts (which
+// only the caller knows the history of). Only entities that can be seen on
+// screen get an instance (see CullKernel.h); visible is scratch space for
+// that. Reuses the capacity of out's vectors.
+void captureSnapshot(const Simulation& simulation, uint64_t tick, RenderSnapshot& out, std::vector<uint32_t>& visible);
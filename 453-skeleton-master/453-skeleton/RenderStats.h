@@ -0,0 +1,29 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Per-frame rendering counters.
+//
+// Anything that issues draw calls or uploads data to the GPU bumps these so
+// that benchmarks and debug overlays can report what a frame actually cost.
+// State changes and uniform updates are counted by GLState. Call reset() once
+// at the start of each frame.
+//------------------------------------------------------------------------------
+
+#include <cstdint>
+
+
+struct RenderStats {
+	uint64_t drawCalls = 0;
+	uint64_t instances = 0;
+	uint64_t bytesUploaded = 0;
+	uint64_t stateChanges = 0;
+	uint64_t redundantStateChanges = 0;	// skipped by GLState
+	uint64_t uniformUpdates = 0;
+
+	void reset() { *this = RenderStats(); }
+
+	static RenderStats& get() {
+		static RenderStats stats;
+		return stats;
+	}
+};
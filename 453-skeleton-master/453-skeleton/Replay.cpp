@@ -0,0 +1,223 @@
+#include "Replay.h"
+
+#include "Log.h"
+#include "Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+
+namespace {
+
+	const char MAGIC[4] = { '4', '5', '3', 'R' };
+	// Only this version is read. Files from earlier versions have no tick
+	// hashes that stateHash() can check, and were recorded before spawning
+	// and rotation changed, so they would replay a different game.
+	const uint64_t VERSION = 3;
+
+	void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	// Maps small negative numbers to small unsigned ones: 0, -1, 1, -2, ...
+	uint64_t zigzag(int64_t value) {
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	int64_t unzigzag(uint64_t value) {
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+
+	void writeFixed64(std::vector<uint8_t>& out, uint64_t value) {
+		for (int i = 0; i < 8; i++) {
+			out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+		}
+	}
+
+	void writeFloat(std::vector<uint8_t>& out, float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		for (int i = 0; i < 4; i++) {
+			out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+		}
+	}
+
+
+	class Reader {
+
+	public:
+		Reader(const std::vector<uint8_t>& data) : data(data), offset(0) {}
+
+		uint8_t byte() {
+			if (offset >= data.size()) throw std::runtime_error("Replay file is truncated");
+			return data[offset++];
+		}
+
+		uint64_t varint() {
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				uint8_t b = byte();
+				value |= static_cast<uint64_t>(b & 0x7F) << shift;
+				if ((b & 0x80) == 0) return value;
+			}
+			throw std::runtime_error("Replay file has a malformed varint");
+		}
+
+		uint64_t fixed64() {
+			uint64_t value = 0;
+			for (int i = 0; i < 8; i++) {
+				value |= static_cast<uint64_t>(byte()) << (8 * i);
+			}
+			return value;
+		}
+
+		float real() {
+			uint32_t bits = 0;
+			for (int i = 0; i < 4; i++) {
+				bits |= static_cast<uint32_t>(byte()) << (8 * i);
+			}
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+	private:
+		const std::vector<uint8_t>& data;
+		size_t offset;
+	};
+}
+
+
+void Replay::save(const std::string& path) const {
+	std::vector<uint8_t> out(MAGIC, MAGIC + 4);
+	writeVarint(out, VERSION);
+	writeVarint(out, seed);
+	writeVarint(out, static_cast<uint64_t>(diamondCount));
+	writeVarint(out, tickCount);
+	writeVarint(out, events.size());
+
+	uint64_t previousTick = 0;
+	int64_t previousTime = events.empty() ? 0 : events.front().event.timeNs;
+	writeVarint(out, zigzag(previousTime));
+
+	for (const ReplayEvent& e : events) {
+		writeVarint(out, e.tick - previousTick);
+		writeVarint(out, zigzag(e.event.timeNs - previousTime));
+		out.push_back(static_cast<uint8_t>(e.event.type));
+		if (e.event.type == InputEventType::TurnToward) {
+			writeFloat(out, e.event.position.x);
+			writeFloat(out, e.event.position.y);
+		}
+		previousTick = e.tick;
+		previousTime = e.event.timeNs;
+	}
+
+	// Hashes are random bits, so varints would only make them bigger
+	writeVarint(out, tickHashes.size());
+	for (uint64_t hash : tickHashes) {
+		writeFixed64(out, hash);
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+	if (!file) {
+		Log::error("REPLAY could not write {}", path);
+		throw std::runtime_error("Failed to write replay file");
+	}
+	Log::info("REPLAY saved {} ticks, {} events in {} bytes to {}", tickCount, events.size(), out.size(), path);
+}
+
+
+Replay Replay::load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		Log::error("REPLAY could not open {}", path);
+		throw std::runtime_error("Failed to open replay file");
+	}
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	Reader in(data);
+	for (char c : MAGIC) {
+		if (in.byte() != static_cast<uint8_t>(c)) throw std::runtime_error("Not a replay file");
+	}
+	uint64_t version = in.varint();
+	if (version != VERSION) throw std::runtime_error("Unsupported replay version");
+
+	Replay replay;
+	replay.seed = static_cast<uint32_t>(in.varint());
+	replay.diamondCount = static_cast<int>(in.varint());
+	replay.tickCount = in.varint();
+	uint64_t count = in.varint();
+
+	uint64_t tick = 0;
+	int64_t time = unzigzag(in.varint());
+
+	// Every event is at least three bytes, so a corrupt count can't make
+	// us reserve far more than the file could hold
+	replay.events.reserve(static_cast<size_t>(std::min<uint64_t>(count, data.size() / 3)));
+	for (uint64_t i = 0; i < count; i++) {
+		ReplayEvent e;
+		tick += in.varint();
+		time += unzigzag(in.varint());
+		e.tick = tick;
+		e.event.timeNs = time;
+
+		uint8_t type = in.byte();
+		if (type > static_cast<uint8_t>(InputEventType::Reset)) throw std::runtime_error("Replay file has an unknown event type");
+		e.event.type = static_cast<InputEventType>(type);
+		if (e.event.type == InputEventType::TurnToward) {
+			e.event.position.x = in.real();
+			e.event.position.y = in.real();
+		}
+		replay.events.push_back(e);
+	}
+
+	uint64_t hashes = in.varint();
+	replay.tickHashes.reserve(static_cast<size_t>(std::min<uint64_t>(hashes, data.size() / 8)));
+	for (uint64_t i = 0; i < hashes; i++) {
+		replay.tickHashes.push_back(in.fixed64());
+	}
+	return replay;
+}
+
+
+ReplayResult playReplay(const Replay& replay, JobSystem& jobs) {
+	auto start = std::chrono::steady_clock::now();
+
+	Simulation simulation(jobs, replay.diamondCount, replay.seed);
+
+	ReplayResult result;
+
+	size_t next = 0;
+	for (uint64_t tick = 1; tick <= replay.tickCount; tick++) {
+		while (next < replay.events.size() && replay.events[next].tick == tick) {
+			simulation.handleInput(replay.events[next].event);
+			next++;
+		}
+		simulation.update();
+
+		if (tick <= replay.tickHashes.size()) {
+			uint64_t expected = replay.tickHashes[tick - 1];
+			uint64_t actual = simulation.stateHash();
+			result.ticksVerified++;
+			if (actual != expected && result.firstDivergentTick == 0) {
+				result.firstDivergentTick = tick;
+				Log::warn("REPLAY diverged at tick {}: state hash {:016x}, recorded {:016x}", tick, actual, expected);
+			}
+		}
+	}
+
+	result.ticks = replay.tickCount;
+	result.score = simulation.getScore();
+	result.won = simulation.hasWon();
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
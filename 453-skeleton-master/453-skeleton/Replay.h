@@ -0,0 +1,72 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Recording and headless playback of play sessions.
+//
+// The simulation is deterministic given its starting seed and the input
+// events applied at each tick, so that is all a Replay stores. Played back
+// without a window and without waiting between ticks, a recorded session
+// runs thousands of times faster than it was played, and reproduces it
+// exactly (for any JobSystem thread count).
+//
+// On disk a replay is a small header followed by the events. All integers
+// are LEB128 varints, and event ticks and timestamps are stored as deltas
+// from the previous event, so a typical event takes 4-6 bytes (clicks also
+// carry their exact position as two raw floats).
+//
+// Recordings also keep Simulation::stateHash() after every tick (8 bytes a
+// tick). Playback recomputes them and reports the first tick where the two
+// runs stopped agreeing, which is where to start looking for whatever made
+// the simulation nondeterministic.
+//
+// Example:
+//		Replay replay = Replay::load("last_session.replay");
+//		ReplayResult result = playReplay(replay, jobs);
+//------------------------------------------------------------------------------
+
+#include "InputEvent.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+class JobSystem;
+
+
+struct ReplayEvent {
+	uint64_t tick;		// the tick that applied the event, counting from 1
+	InputEvent event;
+};
+
+
+struct Replay {
+	uint32_t seed = 0;
+	int diamondCount = 4;
+	uint64_t tickCount = 0;
+	std::vector<ReplayEvent> events;	// ordered by tick
+	std::vector<uint64_t> tickHashes;	// tickHashes[t - 1] is the state hash after tick t
+
+	// Throw std::runtime_error if the file can't be written or read, or is
+	// not a replay
+	void save(const std::string& path) const;
+	static Replay load(const std::string& path);
+};
+
+
+struct ReplayResult {
+	uint64_t ticks = 0;
+	int score = 0;
+	bool won = false;
+	double seconds = 0.0;
+
+	// Number of ticks whose hash was compared against the recording, and the
+	// first one that differed (0 if none did)
+	uint64_t ticksVerified = 0;
+	uint64_t firstDivergentTick = 0;
+};
+
+
+// Runs the whole replay as fast as possible, without rendering, checking
+// the state hash after every tick that has a recorded one
+ReplayResult playReplay(const Replay& replay, JobSystem& jobs);
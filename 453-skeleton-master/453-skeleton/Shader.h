@@ -6,6 +6,7 @@
 
 #include <string>
 
+class ComputeProgram;
 class ShaderProgram;
 
 class Shader {
@@ -25,6 +26,7 @@ public:
 	GLenum getType() const { return type; }
 
 	void friend attach(ShaderProgram& sp, Shader& s);
+	void friend attach(ComputeProgram& cp, Shader& s);
 
 private:
 	ShaderHandle shaderID;
@@ -8,16 +8,29 @@
 
 
 ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
+	: ShaderProgram(vertexPath, fragmentPath, {})
+{}
+
+
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& feedbackVaryings)
 	: programID()
 	, vertex(vertexPath, GL_VERTEX_SHADER)
 	, fragment(fragmentPath, GL_FRAGMENT_SHADER)
+	, feedbackVaryings(feedbackVaryings)
 {
 	attach(*this, vertex);
 	attach(*this, fragment);
+
+	// Has to be set before linking
+	if (!feedbackVaryings.empty()) {
+		std::vector<const GLchar*> names;
+		for (const std::string& name : feedbackVaryings) names.push_back(name.c_str());
+		glTransformFeedbackVaryings(programID, static_cast<GLsizei>(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+	}
 	glLinkProgram(programID);
 
 	if (!checkAndLogLinkSuccess()) {
-		glDeleteProgram(programID);
+		// programID's destructor gives the name back
 		throw std::runtime_error("Shaders did not link.");
 	}
 }
@@ -26,7 +39,11 @@ bool ShaderProgram::recompile() {
 
 	try {
 		// Try to create a new program
-		ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
+		ShaderProgram newProgram(vertex.getPath(), fragment.getPath(), feedbackVaryings);
+
+		// Swaps the programs, so newProgram takes the old one with it. Draws
+		// already queued may still use that, so its handle only releases it
+		// and it is deleted once they are done (see GLObjectPool).
 		*this = std::move(newProgram);
 		return true;
 	}
@@ -3,10 +3,12 @@
 #include "Shader.h"
 
 #include "GLHandles.h"
+#include "GLState.h"
 
 #include <GL/glew.h>
 
 #include <string>
+#include <vector>
 
 
 class ShaderProgram {
@@ -14,6 +16,11 @@ class ShaderProgram {
 public:
 	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
 
+	// For transform feedback: the named vertex shader outputs are captured,
+	// interleaved in this order, into the buffer bound to
+	// GL_TRANSFORM_FEEDBACK_BUFFER binding 0
+	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& feedbackVaryings);
+
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -23,7 +30,7 @@ public:
 
 	// Public interface
 	bool recompile();
-	void use() const { glUseProgram(programID); }
+	void use() const { GLState::get().useProgram(programID); }
 
 	void friend attach(ShaderProgram& sp, Shader& s);
 
@@ -37,6 +44,7 @@ private:
 
 	Shader vertex;
 	Shader fragment;
+	std::vector<std::string> feedbackVaryings;
 
 	bool checkAndLogLinkSuccess() const;
 };
@@ -0,0 +1,369 @@
+#include "Simulation.h"
+
+#include "GameMath.h"
+#include "JobSystem.h"
+#include "OrbitKernel.h"
+#include "XXHash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+
+namespace {
+
+	// With this few ships it is cheaper to sweep every entity with the SIMD
+	// orbit test than to build the grid
+	const size_t SWEEP_MAX_SHIPS = 8;
+
+	const uint32_t NO_OWNER = 0xFFFFFFFFu;
+
+	// Entities per state hash chunk
+	const size_t HASH_CHUNK = 1024;
+
+	// Entities per parallelFor chunk. Sweep chunks must be a multiple of 64
+	// so every chunk fills whole hit mask words. Easing marks the hash
+	// chunks it changed, so its chunks must not share one.
+	const size_t EASE_GRAIN = HASH_CHUNK;
+	const size_t SWEEP_GRAIN = 4096;
+	const size_t QUERY_GRAIN = 512;
+
+	// Below this many entities hashing the arrays is faster than handing
+	// them out to other threads
+	const size_t PARALLEL_HASH_MIN = 16384;
+	const size_t HASH_GRAIN = 16;	// hash chunks
+
+	// One bit per component array in Simulation::dirtyChunks, in the order
+	// stateHash() hashes them
+	const uint16_t HASH_X = 1 << 0;
+	const uint16_t HASH_Y = 1 << 1;
+	const uint16_t HASH_TARGET_X = 1 << 2;
+	const uint16_t HASH_TARGET_Y = 1 << 3;
+	const uint16_t HASH_ROTATION_COS = 1 << 4;
+	const uint16_t HASH_ROTATION_SIN = 1 << 5;
+	const uint16_t HASH_DIRECTION_X = 1 << 6;
+	const uint16_t HASH_DIRECTION_Y = 1 << 7;
+	const uint16_t HASH_SCALE = 1 << 8;
+	const uint16_t HASH_KIND = 1 << 9;
+	const uint16_t HASH_ALL = (1 << 10) - 1;
+}
+
+
+Simulation::Simulation(JobSystem& jobs, int diamondCount, uint32_t seed, int shipCount)
+	: jobs(jobs)
+	, random(seed)
+	, spawnX()
+	, spawnY()
+	, entities()
+	, tweens()
+	, ship()
+	, diamondCount(diamondCount)
+	, shipCount(std::max(shipCount, 1))
+	, score(0)
+	, forwardHeld(false)
+	, backwardHeld(false)
+	, forwardTapped(false)
+	, backwardTapped(false)
+	, broadphaseMode(Broadphase::Auto)
+	, broadphase(ORBIT_RADIUS)
+	, ships()
+	, shipX()
+	, shipY()
+	, owner()
+	, collected()
+	, hitMask()
+	, collectedPositions()
+	, collectedOwners()
+	, chunkHashes()
+	, dirtyChunks()
+{
+	reset();
+}
+
+
+void Simulation::reset() {
+	entities.clear();
+	entities.reserve(diamondCount + shipCount);
+	tweens.clear();
+	tweens.reserve(diamondCount + shipCount);
+
+	Rng& rng = random.get(RandomStream::Spawning);
+
+	// Diamonds and their tweens are created in bulk. perf_random respawns a
+	// million in about 35 ms, which is mostly writing their ~100 MB of
+	// state; a first spawn also faults that memory in, and takes about 90 ms
+	size_t diamonds = static_cast<size_t>(diamondCount);
+	spawnX.resize(diamonds);
+	spawnY.resize(diamonds);
+	scatterDiamonds(rng, spawnX.data(), spawnY.data(), diamonds);
+	entities.createMany(EntityKind::Diamond, spawnX.data(), spawnY.data(), diamonds, 0.0f);
+
+	float shipX = rng.uniform(-0.5f, 0.5f);
+	float shipY = rng.uniform(-0.5f, 0.5f);
+	ship = entities.create(EntityKind::Ship, glm::vec2(shipX, shipY), 0.0f);
+
+	// Drawn after the player's ship, so they don't move it
+	for (int i = 1; i < shipCount; i++) {
+		float x = rng.uniform(-0.5f, 0.5f);
+		float y = rng.uniform(-0.5f, 0.5f);
+		entities.create(EntityKind::Ship, glm::vec2(x, y), 0.0f);
+	}
+
+	// Everything pops in from nothing
+	tweens.startMany(entities, 0, entities.size(), TweenChannel::Scale, 0.0f, DEFAULT_SCALE, SPAWN_TICKS, EaseCurve::BackOut);
+
+	score = 0;
+	dirtyChunks.assign((entities.size() + HASH_CHUNK - 1) / HASH_CHUNK, HASH_ALL);
+}
+
+
+void Simulation::turnShipToward(glm::vec2 target) {
+	size_t s = entities.indexOf(ship);
+	glm::vec2 current(entities.directionX[s], entities.directionY[s]);
+	glm::vec2 direction = directionToward(target, entities.position(s), current);
+	entities.directionX[s] = direction.x;
+	entities.directionY[s] = direction.y;
+	markWritten(s, HASH_DIRECTION_X | HASH_DIRECTION_Y);
+}
+
+
+void Simulation::moveShipForward() {
+	std::tuple new_positions = moveShip(entities.direction(entities.indexOf(ship)));
+	moveShipBy(std::get<0>(new_positions), std::get<1>(new_positions));
+}
+
+
+void Simulation::moveShipBackward() {
+	std::tuple new_positions = moveShip(entities.direction(entities.indexOf(ship)));
+	moveShipBy(-std::get<0>(new_positions), -std::get<1>(new_positions));
+}
+
+
+void Simulation::moveShipBy(float dx, float dy) {
+	size_t s = entities.indexOf(ship);
+	entities.targetX[s] += dx;
+	entities.targetY[s] += dy;
+	markWritten(s, HASH_TARGET_X | HASH_TARGET_Y);
+
+	// Holding a key restarts the glide every tick, from wherever the ship
+	// has got to, so it never stops and starts
+	tweens.start(ship, TweenChannel::X, entities.x[s], entities.targetX[s], MOVE_TICKS, EaseCurve::QuadOut);
+	tweens.start(ship, TweenChannel::Y, entities.y[s], entities.targetY[s], MOVE_TICKS, EaseCurve::QuadOut);
+}
+
+
+void Simulation::handleInput(const InputEvent& event) {
+	switch (event.type) {
+	case InputEventType::TurnToward:
+		turnShipToward(event.position);
+		break;
+	case InputEventType::ForwardPressed:
+		forwardHeld = true;
+		forwardTapped = true;
+		break;
+	case InputEventType::ForwardReleased:
+		forwardHeld = false;
+		break;
+	case InputEventType::BackwardPressed:
+		backwardHeld = true;
+		backwardTapped = true;
+		break;
+	case InputEventType::BackwardReleased:
+		backwardHeld = false;
+		break;
+	case InputEventType::Reset:
+		reset();
+		break;
+	}
+}
+
+
+void Simulation::update() {
+	if (forwardHeld || forwardTapped) moveShipForward();
+	if (backwardHeld || backwardTapped) moveShipBackward();
+	forwardTapped = false;
+	backwardTapped = false;
+
+	easeTowardTargets();
+	collectDiamonds();
+}
+
+
+uint64_t Simulation::stateHash() const {
+	struct Span {
+		const void* data;
+		size_t elementSize;
+	};
+
+	const Span arrays[] = {
+		{ entities.x.data(), sizeof(float) },
+		{ entities.y.data(), sizeof(float) },
+		{ entities.targetX.data(), sizeof(float) },
+		{ entities.targetY.data(), sizeof(float) },
+		{ entities.rotationCos.data(), sizeof(float) },
+		{ entities.rotationSin.data(), sizeof(float) },
+		{ entities.directionX.data(), sizeof(float) },
+		{ entities.directionY.data(), sizeof(float) },
+		{ entities.scale.data(), sizeof(float) },
+		{ entities.kind.data(), sizeof(EntityKind) }
+	};
+	const size_t ARRAYS = sizeof(arrays) / sizeof(arrays[0]);
+
+	size_t n = entities.size();
+	size_t chunks = (n + HASH_CHUNK - 1) / HASH_CHUNK;
+	chunkHashes.resize(chunks * ARRAYS);
+	dirtyChunks.resize(chunks, HASH_ALL);
+
+	// Every chunk of every array is hashed on its own and the results are
+	// combined in a fixed order, so the hash doesn't depend on how the work
+	// was split or on which chunks had to be hashed again
+	auto hashChunks = [&](size_t begin, size_t end) {
+		for (size_t c = begin; c < end; c++) {
+			if (dirtyChunks[c] == 0) continue;
+
+			size_t first = c * HASH_CHUNK;
+			size_t count = std::min(n - first, HASH_CHUNK);
+			for (size_t a = 0; a < ARRAYS; a++) {
+				if ((dirtyChunks[c] & (1u << a)) == 0) continue;
+
+				const uint8_t* data = static_cast<const uint8_t*>(arrays[a].data) + first * arrays[a].elementSize;
+				chunkHashes[c * ARRAYS + a] = xxHash64(data, count * arrays[a].elementSize, a);
+			}
+			dirtyChunks[c] = 0;
+		}
+	};
+	if (n >= PARALLEL_HASH_MIN) jobs.parallelFor(chunks, HASH_GRAIN, hashChunks);
+	else hashChunks(0, chunks);
+
+	// The generator state decides where the next reset() puts things.
+	// RandomStreams is nothing but uint32_t arrays, so it has no padding.
+	const int32_t scalars[] = { score, forwardHeld, backwardHeld, forwardTapped, backwardTapped };
+	uint64_t h = xxHash64(scalars, sizeof(scalars), xxHash64(&random, sizeof(random), tweens.stateHash(ARRAYS)));
+
+	return xxHash64(chunkHashes.data(), chunkHashes.size() * sizeof(uint64_t), h);
+}
+
+
+void Simulation::markWritten(size_t index, uint16_t arrays) {
+	dirtyChunks[index / HASH_CHUNK] |= arrays;
+}
+
+
+void Simulation::easeTowardTargets() {
+	// The target rotation of (cos, sin) is (directionY, directionX), see
+	// rotationFacing()
+	float* rotationCos = entities.rotationCos.data();
+	float* rotationSin = entities.rotationSin.data();
+	const float* directionX = entities.directionX.data();
+	const float* directionY = entities.directionY.data();
+
+	// Every entity turns independently of the others. Once everything
+	// faces where it is going nothing changes, and no chunk needs hashing.
+	uint16_t* dirty = dirtyChunks.data();
+	jobs.parallelFor(entities.size(), EASE_GRAIN, [&](size_t begin, size_t end) {
+		for (size_t first = begin; first < end; first += HASH_CHUNK) {
+			size_t count = std::min(end - first, HASH_CHUNK);
+			if (turnTowards(rotationCos + first, rotationSin + first, directionY + first, directionX + first, count, TURN_STEP) > 0) {
+				dirty[first / HASH_CHUNK] |= HASH_ROTATION_COS | HASH_ROTATION_SIN;
+			}
+		}
+	});
+
+	// Positions and scales only change while a tween is running on them
+	tweens.forEachTarget(entities, [&](size_t i, TweenChannel channel) {
+		if (channel == TweenChannel::X) markWritten(i, HASH_X);
+		else if (channel == TweenChannel::Y) markWritten(i, HASH_Y);
+		else markWritten(i, HASH_SCALE);
+	});
+	tweens.update(entities, jobs);
+}
+
+
+void Simulation::collectDiamonds() {
+	size_t n = entities.size();
+	const float* x = entities.x.data();
+	const float* y = entities.y.data();
+	const EntityKind* kind = entities.kind.data();
+
+	ships.clear();
+	for (size_t i = 0; i < n; i++) {
+		if (kind[i] == EntityKind::Ship) ships.push_back(static_cast<uint32_t>(i));
+	}
+
+	// Each diamond within orbit goes to the lowest indexed ship that reaches
+	// it. That is what checking ships one after another would do, but it
+	// lets every diamond be decided independently, in parallel, and with the
+	// same result for any thread count.
+	owner.assign(n, NO_OWNER);
+	uint32_t* owners = owner.data();
+
+	bool sweep = broadphaseMode == Broadphase::Auto ? ships.size() <= SWEEP_MAX_SHIPS : broadphaseMode == Broadphase::Sweep;
+	if (sweep) {
+		// Few ships: sweep everything with the SIMD orbit test
+		hitMask.resize(hitMaskWords(n));
+		jobs.parallelFor(n, SWEEP_GRAIN, [&](size_t begin, size_t end) {
+			uint64_t* mask = hitMask.data() + begin / 64;
+			for (uint32_t s : ships) {
+				if (orbitHitMask(entities.position(s), ORBIT_RADIUS, x + begin, y + begin, end - begin, mask) == 0) continue;
+
+				forEachHit(mask, end - begin, [&](size_t offset) {
+					size_t i = begin + offset;
+					if (kind[i] == EntityKind::Diamond && owners[i] == NO_OWNER) owners[i] = s;
+				});
+			}
+		});
+	}
+	else {
+		// Many ships: the grid only holds ships, so each diamond is only
+		// distance checked against the ships in the cells around it
+		shipX.resize(ships.size());
+		shipY.resize(ships.size());
+		for (size_t k = 0; k < ships.size(); k++) {
+			shipX[k] = x[ships[k]];
+			shipY[k] = y[ships[k]];
+		}
+		broadphase.build(shipX.data(), shipY.data(), ships.size());
+
+		jobs.parallelFor(n, QUERY_GRAIN, [&](size_t begin, size_t end) {
+			std::vector<uint32_t> nearby;
+			for (size_t i = begin; i < end; i++) {
+				if (kind[i] != EntityKind::Diamond) continue;
+
+				// ships is in index order, so the lowest k found is the
+				// lowest indexed ship
+				nearby.clear();
+				broadphase.queryRadius(entities.position(i), ORBIT_RADIUS, shipX.data(), shipY.data(), nearby);
+				for (uint32_t k : nearby) owners[i] = std::min(owners[i], ships[k]);
+			}
+		});
+	}
+
+	// Scoring touches shared state, so it stays a short serial pass
+	collected.clear();
+	collectedPositions.clear();
+	collectedOwners.clear();
+	for (size_t i = 0; i < n; i++) {
+		if (owners[i] == NO_OWNER) continue;
+
+		collected.push_back(static_cast<uint32_t>(i));
+		collectedPositions.push_back(entities.position(i));
+		score += 1;
+
+		// Grow from the current size towards 5% more than wherever the ship
+		// was already growing to, so collecting several at once compounds,
+		// up to the same cap as the GPU simulation
+		EntityHandle owned = entities.handleAt(owners[i]);
+		collectedOwners.push_back(owned);
+		float current = entities.scale[owners[i]];
+		float grown = std::min(tweens.endValue(owned, TweenChannel::Scale, current) * GROW_FACTOR, MAX_SHIP_SCALE);
+		tweens.start(owned, TweenChannel::Scale, current, grown, GROW_TICKS, EaseCurve::BackOut);
+	}
+
+	// Destroy from the back so that the entity swap-removed into each hole
+	// is never one that is still waiting to be destroyed.
+	for (auto it = collected.rbegin(); it != collected.rend(); ++it) {
+		markWritten(*it, HASH_ALL);
+		markWritten(entities.size() - 1, HASH_ALL);
+		entities.destroy(entities.handleAt(*it));
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// The game rules: where things spawn, how the ship turns and moves, and how
+// diamonds get collected. Owns all entity state in an EntityStore.
+//
+// Nothing in here touches OpenGL, so the simulation can be run (and
+// benchmarked) without a window. The per-entity steps are spread over the
+// given JobSystem; results do not depend on its thread count.
+//------------------------------------------------------------------------------
+
+#include "EntityStore.h"
+#include "InputEvent.h"
+#include "Random.h"
+#include "SpatialHash.h"
+#include "TweenSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+class JobSystem;
+
+
+// How collectDiamonds() finds the diamonds within orbit of each ship
+enum class Broadphase {
+	Auto,		// sweep with few ships, the grid with many
+	Sweep,		// test every entity against every ship with the SIMD kernel
+	Grid		// query a SpatialHash around every diamond
+};
+
+
+class Simulation {
+
+public:
+	// The same seed and the same input always play out the same way. The
+	// player steers the first ship; any others stay where they spawn.
+	Simulation(JobSystem& jobs, int diamondCount = 4, uint32_t seed = 0, int shipCount = 1);
+
+	// Puts the ship and the diamonds back in random starting positions.
+	// Each reset draws new positions from the seeded spawning stream.
+	void reset();
+
+	// Player actions
+	void turnShipToward(glm::vec2 target);
+	void moveShipForward();
+	void moveShipBackward();
+
+	// Applies one input event. Call for every event queued since the last
+	// update(), in order.
+	void handleInput(const InputEvent& event);
+
+	// Advances the simulation by one frame: moves the ship while forward or
+	// backward is held (or was tapped since the last update), turns
+	// everything towards its facing direction, advances the running tweens
+	// (movement, spawning, growing), then collects diamonds within orbit.
+	void update();
+
+	// Fingerprint of everything that affects future ticks: every component
+	// array, the running tweens, the score, the held keys and the random
+	// number generators. Two runs that hash the same after a tick will keep
+	// doing the same thing given the same input.
+	//
+	// The arrays are hashed in chunks, and only the chunks written since the
+	// last call are hashed again, so once things settle a tick costs little
+	// more than combining the chunk hashes.
+	uint64_t stateHash() const;
+
+	// Both broadphases give the same result; forcing one is for comparing
+	// them
+	void setBroadphase(Broadphase mode) { broadphaseMode = mode; }
+
+	const EntityStore& getEntities() const { return entities; }
+	EntityHandle getShip() const { return ship; }
+	int getScore() const { return score; }
+	bool hasWon() const { return score >= diamondCount; }
+
+	// 1 while the ship is moving forward, -1 backward, 0 otherwise
+	int getThrust() const { return (forwardHeld ? 1 : 0) - (backwardHeld ? 1 : 0); }
+
+	// Where the diamonds collected by the last update() were
+	const std::vector<glm::vec2>& getCollectedPositions() const { return collectedPositions; }
+
+	// Which ship collected each of them, in the same order
+	const std::vector<EntityHandle>& getCollectedOwners() const { return collectedOwners; }
+
+private:
+	JobSystem& jobs;
+	RandomStreams random;
+	std::vector<float> spawnX;
+	std::vector<float> spawnY;
+	EntityStore entities;
+	TweenSystem tweens;
+	EntityHandle ship;
+	int diamondCount;
+	int shipCount;
+	int score;
+
+	// Held keys move the ship every update. A press that is released again
+	// before the next update still moves it once.
+	bool forwardHeld;
+	bool backwardHeld;
+	bool forwardTapped;
+	bool backwardTapped;
+
+	// Broadphase and scratch space for collectDiamonds(), kept between
+	// ticks so collecting doesn't allocate. Few ships sweep everything with
+	// orbitHitMask() into hitMask; many ships are bucketed in the grid (at
+	// shipX, shipY) and every diamond queries it instead.
+	Broadphase broadphaseMode;
+	SpatialHash broadphase;
+	std::vector<uint32_t> ships;
+	std::vector<float> shipX;
+	std::vector<float> shipY;
+	std::vector<uint32_t> owner;
+	std::vector<uint32_t> collected;
+	std::vector<uint64_t> hitMask;
+	std::vector<glm::vec2> collectedPositions;
+	std::vector<EntityHandle> collectedOwners;
+
+	// Hash of every component array chunk, chunk * arrays + array, and a
+	// bit per array for each chunk written since it was last hashed
+	mutable std::vector<uint64_t> chunkHashes;
+	mutable std::vector<uint16_t> dirtyChunks;
+
+	// Marks the given arrays (bits, see Simulation.cpp) of entity index
+	// as written
+	void markWritten(size_t index, uint16_t arrays);
+
+	// Moves the ship's target position and glides it there
+	void moveShipBy(float dx, float dy);
+
+	void easeTowardTargets();
+	void collectDiamonds();
+};
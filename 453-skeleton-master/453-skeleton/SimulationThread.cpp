@@ -0,0 +1,119 @@
+#include "SimulationThread.h"
+
+#include "FlightRecorder.h"
+#include "Log.h"
+#include "Replay.h"
+#include "Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+
+
+namespace {
+
+	// How many ticks a collection stays in the snapshots. The renderer
+	// would have to skip this many snapshots in a row to miss one.
+	const uint64_t BURST_TICKS = 8;
+
+	// Big worlds can collect thousands of diamonds in one tick. Past this
+	// many the explosions are indistinguishable anyway.
+	const size_t MAX_BURSTS_PER_TICK = 64;
+}
+
+
+SimulationThread::SimulationThread(Simulation& simulation, InputQueue& input, double ticksPerSecond)
+	: simulation(simulation)
+	, input(input)
+	, ticksPerSecond(ticksPerSecond)
+	, snapshots()
+	, tick(0)
+	, running(false)
+	, thread()
+	, recording(nullptr)
+	, recentBursts()
+	, visible()
+{
+	captureSnapshot(simulation, 0, snapshots.writeBuffer(), visible);
+	snapshots.publish();
+}
+
+
+SimulationThread::~SimulationThread() {
+	stop();
+}
+
+
+void SimulationThread::start() {
+	if (running) return;
+
+	running = true;
+	thread = std::thread(&SimulationThread::run, this);
+	Log::info("SIMULATION thread started at {} ticks per second", ticksPerSecond);
+}
+
+
+void SimulationThread::stop() {
+	running = false;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+
+const RenderSnapshot& SimulationThread::latest() {
+	snapshots.update();
+	return snapshots.readBuffer();
+}
+
+
+void SimulationThread::run() {
+	using Clock = std::chrono::steady_clock;
+	const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / ticksPerSecond));
+
+	// Most ticks we are allowed to fall behind before giving up on catching
+	// up, e.g. after sitting in a debugger
+	const int MAX_CATCH_UP = 5;
+
+	Clock::time_point next = Clock::now();
+	while (running) {
+		step();
+
+		next += period;
+		Clock::time_point now = Clock::now();
+		if (now > next + period * MAX_CATCH_UP) {
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+	}
+}
+
+
+void SimulationThread::step() {
+	ProfileScope scope("simulation_tick");
+
+	uint64_t t = tick.load(std::memory_order_relaxed) + 1;
+
+	InputEvent event;
+	while (input.tryPop(event)) {
+		simulation.handleInput(event);
+		if (recording) recording->events.push_back(ReplayEvent{ t, event });
+	}
+	simulation.update();
+	if (recording) {
+		recording->tickCount = t;
+		recording->tickHashes.push_back(simulation.stateHash());
+	}
+
+	recentBursts.erase(std::remove_if(recentBursts.begin(), recentBursts.end(),
+		[&](const ParticleBurst& burst) { return burst.tick + BURST_TICKS <= t; }), recentBursts.end());
+	const std::vector<glm::vec2>& collected = simulation.getCollectedPositions();
+	for (size_t i = 0; i < std::min(collected.size(), MAX_BURSTS_PER_TICK); i++) {
+		recentBursts.push_back(ParticleBurst{ t, collected[i] });
+	}
+
+	RenderSnapshot& snapshot = snapshots.writeBuffer();
+	captureSnapshot(simulation, t, snapshot, visible);
+	snapshot.bursts = recentBursts;
+	snapshots.publish();
+	tick.store(t, std::memory_order_relaxed);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Runs a Simulation on its own thread at a fixed tick rate.
+//
+// Every tick drains the input queue into the simulation, updates it, and
+// publishes a RenderSnapshot through a triple buffer. The render thread only
+// ever reads the latest complete snapshot, so a slow frame no longer slows
+// gameplay down and simulating overlaps with submitting GL work.
+//
+// While the thread runs the Simulation belongs to it; don't touch the
+// Simulation from anywhere else until stop() has returned.
+//
+// Example:
+//		SimulationThread simulationThread(simulation, input);
+//		simulationThread.start();
+//		while (...) { draw(simulationThread.latest()); }
+//------------------------------------------------------------------------------
+
+#include "InputEvent.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+class Simulation;
+struct Replay;
+
+
+class SimulationThread {
+
+public:
+	// Also publishes a snapshot of the starting state, so latest() has
+	// something to draw before the first tick
+	SimulationThread(Simulation& simulation, InputQueue& input, double ticksPerSecond = 60.0);
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// Appends every input event, with the tick that applied it, and the
+	// state hash after every tick to replay, and keeps its tickCount up to
+	// date. Call before start(); replay may
+	// only be read once stop() has returned.
+	void record(Replay* replay) { recording = replay; }
+
+	void start();
+
+	// Finishes the current tick and joins the thread
+	void stop();
+
+	// Render thread only. The newest published snapshot; stays valid and
+	// unchanged until the next call.
+	const RenderSnapshot& latest();
+
+	uint64_t getTick() const { return tick.load(std::memory_order_relaxed); }
+
+private:
+	Simulation& simulation;
+	InputQueue& input;
+	double ticksPerSecond;
+
+	TripleBuffer<RenderSnapshot> snapshots;
+	std::atomic<uint64_t> tick;
+	std::atomic<bool> running;
+	std::thread thread;
+	Replay* recording;
+
+	// Collections from the last few ticks, copied into every snapshot
+	std::vector<ParticleBurst> recentBursts;
+
+	// Scratch space for captureSnapshot()
+	std::vector<uint32_t> visible;
+
+	void run();
+	void step();
+};
@@ -0,0 +1,103 @@
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+SpatialHash::SpatialHash(float cellSize)
+	: cellSize(cellSize)
+	, inverseCellSize(1.0f / cellSize)
+	, bucketStart()
+	, entries()
+	, pointBucket()
+	, bucketMask(0)
+{}
+
+
+glm::ivec2 SpatialHash::cellOf(float x, float y) const {
+	return glm::ivec2(
+		static_cast<int>(std::floor(x * inverseCellSize)),
+		static_cast<int>(std::floor(y * inverseCellSize))
+	);
+}
+
+
+size_t SpatialHash::bucketOf(glm::ivec2 cell) const {
+	// Large primes from "Optimized Spatial Hashing for Collision Detection
+	// of Deformable Objects" (Teschner et al. 2003)
+	uint32_t h = static_cast<uint32_t>(cell.x) * 73856093u ^ static_cast<uint32_t>(cell.y) * 19349663u;
+	return h & bucketMask;
+}
+
+
+void SpatialHash::build(const float* x, const float* y, size_t count) {
+	// Twice as many buckets as points keeps collisions between cells rare.
+	// Only ever grow the table so steady state rebuilds don't allocate.
+	size_t buckets = 16;
+	while (buckets < count * 2) {
+		buckets <<= 1;
+	}
+	buckets = std::max(buckets, bucketMask + 1);
+	bucketMask = buckets - 1;
+
+	bucketStart.assign(buckets + 1, 0);
+	entries.resize(count);
+	pointBucket.resize(count);
+
+	// Count the points in each bucket
+	for (size_t i = 0; i < count; i++) {
+		size_t b = bucketOf(cellOf(x[i], y[i]));
+		pointBucket[i] = static_cast<uint32_t>(b);
+		bucketStart[b + 1]++;
+	}
+
+	// Prefix sum turns counts into start offsets
+	for (size_t b = 0; b < buckets; b++) {
+		bucketStart[b + 1] += bucketStart[b];
+	}
+
+	// Scatter, then shift the offsets back since scattering advanced them
+	for (size_t i = 0; i < count; i++) {
+		entries[bucketStart[pointBucket[i]]++] = static_cast<uint32_t>(i);
+	}
+	for (size_t b = buckets; b > 0; b--) {
+		bucketStart[b] = bucketStart[b - 1];
+	}
+	bucketStart[0] = 0;
+}
+
+
+void SpatialHash::queryRadius(glm::vec2 center, float radius, const float* x, const float* y, std::vector<uint32_t>& out) const {
+	if (entries.empty()) return;
+
+	glm::ivec2 lo = cellOf(center.x - radius, center.y - radius);
+	glm::ivec2 hi = cellOf(center.x + radius, center.y + radius);
+	float radiusSquared = radius * radius;
+
+	// Different cells can hash to the same bucket; make sure each bucket is
+	// only scanned once so no point is reported twice.
+	size_t visited[16];
+	size_t visitedCount = 0;
+	std::vector<size_t> visitedOverflow;
+
+	for (int cy = lo.y; cy <= hi.y; cy++) {
+		for (int cx = lo.x; cx <= hi.x; cx++) {
+			size_t b = bucketOf(glm::ivec2(cx, cy));
+
+			bool seen = std::find(visited, visited + visitedCount, b) != visited + visitedCount
+				|| std::find(visitedOverflow.begin(), visitedOverflow.end(), b) != visitedOverflow.end();
+			if (seen) continue;
+			if (visitedCount < 16) visited[visitedCount++] = b;
+			else visitedOverflow.push_back(b);
+
+			for (uint32_t e = bucketStart[b]; e < bucketStart[b + 1]; e++) {
+				uint32_t i = entries[e];
+				float dx = x[i] - center.x;
+				float dy = y[i] - center.y;
+				if (dx * dx + dy * dy < radiusSquared) {
+					out.push_back(i);
+				}
+			}
+		}
+	}
+}
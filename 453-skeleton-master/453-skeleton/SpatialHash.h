@@ -0,0 +1,55 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Uniform grid broadphase for "what is near this point" queries.
+//
+// Points are bucketed by the grid cell they fall in. Cells are hashed into a
+// fixed size table, so the world does not need bounds and empty space costs
+// nothing. build() is a counting sort over the points (two linear passes and
+// no per-cell allocations), cheap enough to simply rebuild every tick.
+//
+// Queries only visit the cells overlapping the query circle and then do the
+// exact test on squared distances, so checking one point against N others
+// costs roughly the number of points nearby instead of N sqrts.
+//
+// Example:
+//		SpatialHash grid(0.25f);
+//		grid.build(x.data(), y.data(), x.size());
+//		grid.queryRadius(shipPosition, 0.25f, x.data(), y.data(), hits);
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+class SpatialHash {
+
+public:
+	// Queries with a radius up to cellSize visit at most 3x3 cells
+	SpatialHash(float cellSize);
+
+	// Buckets points (x[i], y[i]) for i in [0, count). The arrays are not
+	// copied; queries read positions from the arrays passed to them.
+	void build(const float* x, const float* y, size_t count);
+
+	// Appends the index of every point strictly within radius of center
+	void queryRadius(glm::vec2 center, float radius, const float* x, const float* y, std::vector<uint32_t>& out) const;
+
+	float getCellSize() const { return cellSize; }
+
+private:
+	float cellSize;
+	float inverseCellSize;
+
+	// Bucket b holds entries[bucketStart[b] .. bucketStart[b + 1])
+	std::vector<uint32_t> bucketStart;
+	std::vector<uint32_t> entries;
+	std::vector<uint32_t> pointBucket;
+	size_t bucketMask;
+
+	glm::ivec2 cellOf(float x, float y) const;
+	size_t bucketOf(glm::ivec2 cell) const;
+};
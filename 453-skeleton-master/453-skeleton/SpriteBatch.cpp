@@ -0,0 +1,140 @@
+#include "SpriteBatch.h"
+
+#include "GLState.h"
+#include "RenderStats.h"
+#include "VertexLayout.h"
+
+#include <utility>
+
+
+namespace {
+
+	// Two triangles covering the unit quad every sprite is drawn with
+	const std::vector<glm::vec3> QUAD_VERTS = {
+		{ -1.f,  1.f, 1.f },
+		{ -1.f, -1.f, 1.f },
+		{  1.f, -1.f, 1.f },
+		{ -1.f,  1.f, 1.f },
+		{  1.f, -1.f, 1.f },
+		{  1.f,  1.f, 1.f }
+	};
+
+	const std::vector<glm::vec2> QUAD_TEX_COORDS = {
+		{ 0.f, 1.f },
+		{ 0.f, 0.f },
+		{ 1.f, 0.f },
+		{ 0.f, 1.f },
+		{ 1.f, 0.f },
+		{ 1.f, 1.f }
+	};
+
+	// Locations 0 and 1 of sprite.vert, read from one interleaved buffer
+	using SpriteVertex = VertexLayout<Position3f, TexCoord2f>;
+
+	const GLuint INSTANCE_ATTRIBUTE = 2;
+	const GLuint QUAD_VERTICES = 6;
+}
+
+
+SpriteBatch::SpriteBatch()
+	: vao()
+	, quad(vao, SpriteVertex::interleaved())
+	, instanceBuffer()
+	, source(instanceBuffer)
+	, bound(0)
+	, culler()
+	, culled(false)
+	, count(0)
+	, capacity(0)
+{
+	std::vector<unsigned char> vertices;
+	SpriteVertex::interleave(vertices, QUAD_VERTS, QUAD_TEX_COORDS);
+	quad.uploadData(static_cast<GLsizeiptr>(vertices.size()), vertices.data(), GL_STATIC_DRAW);
+
+	// One vec4 (x, y, scaled cos, scaled sin) per instance, advanced once per instance
+	// rather than once per vertex.
+	readInstancesFrom(instanceBuffer);
+	vao.setDivisor(INSTANCE_ATTRIBUTE, 1);
+}
+
+
+void SpriteBatch::setInstances(const SpriteInstance* data, size_t count_) {
+	count = count_;
+	culled = false;
+	if (count == 0) return;
+	source = instanceBuffer;
+
+	// The instances change every frame, so unlike VertexBuffer this keeps
+	// mutable storage it can orphan, with or without direct state access
+	GLsizeiptr bytes = static_cast<GLsizeiptr>(sizeof(SpriteInstance) * count);
+	bool named = GLState::get().hasDirectStateAccess();
+	if (!named) glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	if (count > capacity) {
+		capacity = count;
+		if (named) glNamedBufferData(instanceBuffer, sizeof(SpriteInstance) * capacity, data, GL_STREAM_DRAW);
+		else glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteInstance) * capacity, data, GL_STREAM_DRAW);
+	}
+	else if (named) {
+		// Orphan the old storage so we never wait on the GPU still reading
+		// last frame's instances.
+		glNamedBufferData(instanceBuffer, sizeof(SpriteInstance) * capacity, nullptr, GL_STREAM_DRAW);
+		glNamedBufferSubData(instanceBuffer, 0, bytes, data);
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteInstance) * capacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+	}
+	RenderStats::get().bytesUploaded += bytes;
+}
+
+
+void SpriteBatch::setInstanceBuffer(GLuint buffer, size_t count_) {
+	count = count_;
+	source = buffer;
+	culled = false;
+}
+
+
+void SpriteBatch::enableCulling() {
+	if (!culler) culler = std::make_unique<SpriteCuller>();
+}
+
+
+void SpriteBatch::cull() {
+	if (!culler || count == 0) return;
+
+	culler->cull(source, count, QUAD_VERTICES);
+	culled = true;
+}
+
+
+void SpriteBatch::draw(Texture& texture) {
+	if (count == 0) return;
+
+	vao.bind();
+	texture.bind();
+	RenderStats& stats = RenderStats::get();
+	stats.drawCalls++;
+
+	if (culled) {
+		// How many survived stays on the GPU, so it can't be counted here
+		readInstancesFrom(culler->getVisible());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler->getCommand());
+		glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		culled = false;
+		return;
+	}
+
+	readInstancesFrom(source);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, QUAD_VERTICES, static_cast<GLsizei>(count));
+	stats.instances += count;
+}
+
+
+void SpriteBatch::readInstancesFrom(GLuint buffer) {
+	if (buffer == bound) return;
+
+	bound = buffer;
+	vao.attachBuffer(INSTANCE_ATTRIBUTE, buffer, 4, GL_FLOAT, sizeof(SpriteInstance));
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Draws many copies of the unit quad used by the game's sprites with a
+// single instanced draw call.
+//
+// Each instance carries the same parameters the v1/v2/theta/scaling_factor
+// uniforms of test.vert do (the last two as scaling_factor * (cos, sin)), so
+// shaders/sprite.vert places a sprite exactly where the per-object path
+// would have. All sprites in a batch share one texture.
+//
+// With culling enabled (GL 4.3), cull() finds the sprites on screen on the
+// GPU and the next draw() only draws those, with an indirect draw whose
+// instance count never comes back to the CPU. See SpriteCuller.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "SpriteCuller.h"
+#include "SpriteInstance.h"
+#include "Texture.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+class SpriteBatch {
+
+public:
+	SpriteBatch();
+
+	// Because we're using the handles to do RAII for us
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+
+	// Public interface
+	void setInstances(const SpriteInstance* data, size_t count);
+	void setInstances(const std::vector<SpriteInstance>& instances) { setInstances(instances.data(), instances.size()); }
+
+	// Draws count instances straight from buffer, e.g. ones a compute
+	// shader wrote (see GpuSimulation), instead of uploading them. The
+	// batch doesn't own buffer. setInstances() switches back.
+	void setInstanceBuffer(GLuint buffer, size_t count);
+
+	// Needs compute shaders, see Window::hasComputeShaders()
+	void enableCulling();
+
+	// Finds which of the current instances are on screen, for the next
+	// draw() only (setting new instances forgets it). Does nothing unless culling is enabled. Runs a compute
+	// shader, so call it before binding the program to draw with.
+	void cull();
+
+	void draw(Texture& texture);
+
+	size_t getCount() const { return count; }
+
+private:
+	// note: due to how OpenGL works, vao needs to be
+	// defined and initialized before the vertex buffers
+	VertexArray vao;
+
+	VertexBuffer quad;		// SpriteVertex, interleaved
+	VertexBufferHandle instanceBuffer;
+	GLuint source;		// instanceBuffer, or the one from setInstanceBuffer()
+	GLuint bound;		// the buffer the instance attribute reads
+
+	std::unique_ptr<SpriteCuller> culler;
+	bool culled;
+
+	size_t count;
+	size_t capacity;
+
+	void readInstancesFrom(GLuint buffer);
+};
@@ -0,0 +1,63 @@
+#include "SpriteCuller.h"
+
+#include "GLState.h"
+#include "SpriteInstance.h"
+
+
+namespace {
+
+	// Same layout as the command glDrawArraysIndirect() reads
+	struct DrawArraysIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	// Storage buffer bindings in sprite_cull.comp
+	const GLuint INSTANCES_BINDING = 0;
+	const GLuint VISIBLE_BINDING = 1;
+	const GLuint COMMAND_BINDING = 2;
+
+	// local_size_x of sprite_cull.comp
+	const size_t CULL_GROUP_SIZE = 256;
+}
+
+
+SpriteCuller::SpriteCuller()
+	: program("shaders/sprite_cull.comp")
+	, visible()
+	, command()
+	, capacity(0)
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawArraysIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+
+void SpriteCuller::cull(GLuint instances, size_t count, GLuint vertices) {
+	if (count > capacity) {
+		capacity = count;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, visible);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SpriteInstance) * capacity, nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	// The shader counts the instances up from 0
+	const DrawArraysIndirectCommand empty = { vertices, 0, 0, 0 };
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(empty), &empty);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES_BINDING, instances);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING, visible);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, command);
+
+	program.use();
+	GLState::get().uniform(program.getID(), "count", static_cast<GLuint>(count));
+	program.dispatch(count, CULL_GROUP_SIZE);
+
+	// The draw reads the command and the visible instances
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// GPU visibility culling for instanced sprites.
+//
+// cull() runs shaders/sprite_cull.comp over a buffer of SpriteInstance. It
+// tests each sprite's bounds against the screen, copies the ones that can
+// be seen into a compact buffer, and counts them straight into an indirect
+// draw command. Drawing with glDrawArraysIndirect() from getCommand() then
+// only draws visible sprites, and the CPU never learns which or how many
+// they were, so nothing is read back and nothing waits for the GPU.
+//
+// Sprites that are off screen or empty (scale 0, e.g. collected diamonds in
+// GpuSimulation) are dropped. The visible sprites don't keep their order.
+//
+// Needs a GL 4.3 context, see Window::hasComputeShaders(). SpriteBatch
+// uses this when culling is enabled.
+//
+// Example:
+//		culler.cull(instances, count, 6);
+//		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.getCommand());
+//		glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+//------------------------------------------------------------------------------
+
+#include "ComputeProgram.h"
+#include "GLHandles.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+
+class SpriteCuller {
+
+public:
+	SpriteCuller();
+
+	// Because we're using the handles to do RAII for us
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+
+	// Copies the visible ones of the count SpriteInstances in instances
+	// into getVisible(), and points getCommand() at them with vertices
+	// vertices per instance. Binds its own program; bind the one to draw
+	// with afterwards.
+	void cull(GLuint instances, size_t count, GLuint vertices);
+
+	GLuint getVisible() const { return visible; }
+	GLuint getCommand() const { return command; }
+
+private:
+	ComputeProgram program;
+	VertexBufferHandle visible;
+	VertexBufferHandle command;
+	size_t capacity;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// One sprite as drawn by SpriteBatch. Kept free of OpenGL so that code off the
+// render thread (see RenderSnapshot) can build instance lists.
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+
+// Matches the layout of the per-instance attribute (location 2) in sprite.vert.
+// rotation is (cos theta, sin theta) already multiplied by the sprite's
+// scale, so the shader only has to do one 2x2 multiply per vertex.
+struct SpriteInstance {
+	glm::vec2 position;
+	glm::vec2 rotation;
+};
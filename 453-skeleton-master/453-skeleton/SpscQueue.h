@@ -0,0 +1,92 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A bounded, lock-free, single producer / single consumer ring buffer.
+//
+// Exactly one thread may push and exactly one (possibly different) thread may
+// pop. Neither side ever blocks or allocates after construction: tryPush()
+// fails when the ring is full and tryPop() fails when it is empty.
+//
+// The producer only writes tail and the consumer only writes head, each on
+// its own cache line. Both sides also keep a private copy of the other's
+// index and only re-read the shared one when their copy says the ring is
+// full (or empty), so in the common case a push or pop touches no cache line
+// the other thread is writing.
+//
+// Example:
+//		SpscQueue<InputEvent> queue(1024);
+//		queue.tryPush(event);				// producer thread
+//		while (queue.tryPop(event)) { ... }	// consumer thread
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+template <typename T>
+class SpscQueue {
+
+public:
+	// Capacity is rounded up to a power of two
+	explicit SpscQueue(size_t capacity)
+		: slots(roundUpToPowerOfTwo(capacity))
+		, mask(slots.size() - 1)
+		, head(0)
+		, cachedTail(0)
+		, tail(0)
+		, cachedHead(0)
+	{}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Producer only. Returns false (and drops value) if the ring is full.
+	bool tryPush(const T& value) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - cachedHead == slots.size()) {
+			cachedHead = head.load(std::memory_order_acquire);
+			if (t - cachedHead == slots.size()) return false;
+		}
+		slots[t & mask] = value;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Returns false if the ring is empty.
+	bool tryPop(T& value) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == cachedTail) {
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (h == cachedTail) return false;
+		}
+		value = slots[h & mask];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Only exact when neither side is running
+	size_t sizeApprox() const {
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const { return slots.size(); }
+
+private:
+	static size_t roundUpToPowerOfTwo(size_t n) {
+		size_t p = 1;
+		while (p < n) p <<= 1;
+		return p;
+	}
+
+	std::vector<T> slots;
+	size_t mask;
+
+	// Consumer side
+	alignas(64) std::atomic<size_t> head;
+	size_t cachedTail;
+
+	// Producer side
+	alignas(64) std::atomic<size_t> tail;
+	size_t cachedHead;
+};
@@ -15,38 +15,60 @@ Texture::Texture(std::string path, GLint interpolation)
 	{
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);		//Set alignment to be 1
 
-		bind();
-
 		//Set number of components by format of the texture
+		//(immutable storage needs the sized version of it)
 		GLuint format = GL_RGB;
+		GLenum sizedFormat = GL_RGB8;
 		switch (numComponents)
 		{
 		case 4:
 			format = GL_RGBA;
+			sizedFormat = GL_RGBA8;
 			break;
 		case 3:
 			format = GL_RGB;
+			sizedFormat = GL_RGB8;
 			break;
 		case 2:
 			format = GL_RG;
+			sizedFormat = GL_RG8;
 			break;
 		case 1:
 			format = GL_RED;
+			sizedFormat = GL_R8;
 			break;
 		default:
 			std::cout << "Invalid Texture Format" << std::endl;
 			break;
 		};
-		//Loads texture data into bound texture
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, interpolation);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, interpolation);
+		if (GLState::get().hasDirectStateAccess())
+		{
+			//Immutable storage with a single level, edited without binding
+			glTextureStorage2D(textureID, 1, sizedFormat, width, height);
+			glTextureSubImage2D(textureID, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+
+			glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, interpolation);
+			glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, interpolation);
+		}
+		else
+		{
+			bind();
+
+			//Loads texture data into bound texture
+			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, interpolation);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, interpolation);
+
+			unbind();
+		}
 
 		// Clean up
-		unbind();
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);	//Return to default alignment
 		stbi_image_free(data);
 
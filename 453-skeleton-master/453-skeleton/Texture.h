@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "GLState.h"
 #include <GL/glew.h>
 #include <string>
 
@@ -26,8 +27,8 @@ public:
 	// the assumption that most students will want to work with ints, not uints, in main.cpp
 	glm::ivec2 getDimensions() const { return glm::uvec2(width, height); }
 
-	void bind() { glBindTexture(GL_TEXTURE_2D, textureID); }
-	void unbind() { glBindTexture(GL_TEXTURE_2D, textureID); }
+	void bind() { GLState::get().bindTexture(textureID); }
+	void unbind() { GLState::get().bindTexture(0); }
 
 private:
 	TextureHandle textureID;
@@ -0,0 +1,77 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Lock-free triple buffer for handing the latest value from one writer thread
+// to one reader thread.
+//
+// The writer fills writeBuffer() and publish()es it; the reader calls
+// update() and then reads readBuffer(). There are three buffers so that
+// neither side ever waits: one is being written, one is being read, and the
+// third holds the newest published value. publish() and update() swap their
+// buffer with that third one using a single atomic exchange. A published
+// buffer is never written again until the reader has moved past it, so the
+// reader always sees a complete, unchanging value. Values the reader never
+// gets to are simply overwritten.
+//
+// Buffers are reused rather than reallocated, so a T holding vectors keeps
+// their capacity and steady state publishing does not allocate.
+//
+// Example:
+//		TripleBuffer<RenderSnapshot> snapshots;
+//		fill(snapshots.writeBuffer()); snapshots.publish();		// writer thread
+//		snapshots.update(); draw(snapshots.readBuffer());		// reader thread
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdint>
+
+
+template <typename T>
+class TripleBuffer {
+
+public:
+	TripleBuffer()
+		: middle(1)
+		, back(0)
+		, front(2)
+	{}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer only
+	T& writeBuffer() { return slots[back].value; }
+
+	// Writer only. Makes the write buffer the newest value and hands the
+	// writer a stale buffer to fill next.
+	void publish() {
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader only. Moves to the newest published value, if there is one
+	// the reader hasn't seen yet. Returns whether it did.
+	bool update() {
+		if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	// Reader only
+	const T& readBuffer() const { return slots[front].value; }
+
+private:
+	// The middle index carries a flag saying it was published since the
+	// reader last took it
+	static const uint8_t INDEX = 0x3;
+	static const uint8_t FRESH = 0x4;
+
+	// Separate cache lines so the two threads don't false share
+	struct alignas(64) Slot {
+		T value;
+	};
+
+	Slot slots[3];
+	alignas(64) std::atomic<uint8_t> middle;
+	alignas(64) uint8_t back;
+	alignas(64) uint8_t front;
+};
@@ -0,0 +1,259 @@
+#include "TweenSystem.h"
+
+#include "JobSystem.h"
+#include "XXHash.h"
+
+#include <algorithm>
+
+
+namespace {
+
+	const size_t CHANNELS = static_cast<size_t>(TweenChannel::Count);
+
+	const uint32_t NO_TWEEN = 0xFFFFFFFFu;
+
+	// Tweens per parallelFor chunk
+	const size_t TWEEN_GRAIN = 1024;
+
+	// How far BackOut overshoots (about 10%)
+	const float BACK_C1 = 1.70158f;
+	const float BACK_C3 = BACK_C1 + 1.0f;
+
+	// Every curve is computed and the right one selected, so this has no
+	// branches the compiler can't turn into selects
+	inline float easeAny(EaseCurve curve, float t) {
+		float quadOut = t * (2.0f - t);
+		float u = 2.0f * t - 2.0f;
+		float cubicInOut = t < 0.5f ? 4.0f * t * t * t : 1.0f + 0.5f * u * u * u;
+		float smoothStep = t * t * (3.0f - 2.0f * t);
+		float v = t - 1.0f;
+		float backOut = 1.0f + v * v * (BACK_C3 * v + BACK_C1);
+
+		float e = t;
+		e = curve == EaseCurve::QuadOut ? quadOut : e;
+		e = curve == EaseCurve::CubicInOut ? cubicInOut : e;
+		e = curve == EaseCurve::SmoothStep ? smoothStep : e;
+		e = curve == EaseCurve::BackOut ? backOut : e;
+		return e;
+	}
+}
+
+
+float ease(EaseCurve curve, float t) {
+	return easeAny(curve, t);
+}
+
+
+TweenSystem::TweenSystem()
+	: entity()
+	, channel()
+	, curve()
+	, from()
+	, to()
+	, progress()
+	, step()
+	, value()
+	, finished()
+	, running()
+{}
+
+
+void TweenSystem::start(EntityHandle entity_, TweenChannel channel_, float from_, float to_, int ticks, EaseCurve curve_) {
+	uint32_t i = find(entity_, channel_);
+	if (i == NO_TWEEN) {
+		i = static_cast<uint32_t>(size());
+		entity.push_back(entity_);
+		channel.push_back(channel_);
+		curve.push_back(curve_);
+		from.push_back(0.0f);
+		to.push_back(0.0f);
+		progress.push_back(0.0f);
+		step.push_back(0.0f);
+
+		size_t k = key(entity_, channel_);
+		if (k >= running.size()) running.resize(k + 1, NO_TWEEN);
+		running[k] = i;
+	}
+
+	curve[i] = curve_;
+	from[i] = from_;
+	to[i] = to_;
+	progress[i] = 0.0f;
+	step[i] = 1.0f / static_cast<float>(std::max(ticks, 1));
+}
+
+
+void TweenSystem::startMany(const EntityStore& entities, size_t first, size_t count, TweenChannel channel_, float from_, float to_, int ticks, EaseCurve curve_) {
+	size_t keys = entities.slotCount() * CHANNELS;
+	if (running.size() < keys) running.resize(keys, NO_TWEEN);
+
+	// New tweens all start the same, so the fills set everything but the
+	// handles. Channels that already have a tween are restarted in place
+	// and the unused tail is trimmed off at the end.
+	float step_ = 1.0f / static_cast<float>(std::max(ticks, 1));
+	size_t n = size() + count;
+	entity.resize(n);
+	channel.resize(n, channel_);
+	curve.resize(n, curve_);
+	from.resize(n, from_);
+	to.resize(n, to_);
+	progress.resize(n, 0.0f);
+	step.resize(n, step_);
+
+	size_t added = n - count;
+	for (size_t d = first; d < first + count; d++) {
+		EntityHandle h = entities.handleAt(d);
+		uint32_t i = find(h, channel_);
+		if (i == NO_TWEEN) {
+			entity[added] = h;
+			running[key(h, channel_)] = static_cast<uint32_t>(added);
+			added++;
+			continue;
+		}
+
+		curve[i] = curve_;
+		from[i] = from_;
+		to[i] = to_;
+		progress[i] = 0.0f;
+		step[i] = step_;
+	}
+
+	entity.resize(added);
+	channel.resize(added);
+	curve.resize(added);
+	from.resize(added);
+	to.resize(added);
+	progress.resize(added);
+	step.resize(added);
+}
+
+
+float TweenSystem::endValue(EntityHandle entity_, TweenChannel channel_, float current) const {
+	uint32_t i = find(entity_, channel_);
+	return i == NO_TWEEN ? current : to[i];
+}
+
+
+bool TweenSystem::isRunning(EntityHandle entity_, TweenChannel channel_) const {
+	return find(entity_, channel_) != NO_TWEEN;
+}
+
+
+void TweenSystem::update(EntityStore& entities, JobSystem& jobs) {
+	size_t n = size();
+	if (n == 0) return;
+
+	value.resize(n);
+	finished.resize(n);
+	float* components[CHANNELS] = { entities.x.data(), entities.y.data(), entities.scale.data() };
+
+	// Advance and evaluate every tween, then write the values out. Each
+	// entity channel has at most one tween, so chunks never write to the
+	// same component.
+	jobs.parallelFor(n, TWEEN_GRAIN, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			float p = std::min(progress[i] + step[i], 1.0f);
+			float e = easeAny(curve[i], p);
+			progress[i] = p;
+			value[i] = p >= 1.0f ? to[i] : from[i] + (to[i] - from[i]) * e;
+		}
+
+		for (size_t i = begin; i < end; i++) {
+			if (!entities.isAlive(entity[i])) {
+				finished[i] = 1;
+				continue;
+			}
+			components[static_cast<size_t>(channel[i])][entities.indexOf(entity[i])] = value[i];
+			finished[i] = progress[i] >= 1.0f;
+		}
+	});
+
+	// Retire everything that finished in one pass, keeping the order of
+	// the tweens that are left
+	size_t kept = 0;
+	for (size_t i = 0; i < n; i++) {
+		size_t k = key(entity[i], channel[i]);
+		if (finished[i]) {
+			// A newer tween may already own the channel if the entity's
+			// slot was reused
+			if (running[k] == i) running[k] = NO_TWEEN;
+			continue;
+		}
+
+		if (kept != i) {
+			entity[kept] = entity[i];
+			channel[kept] = channel[i];
+			curve[kept] = curve[i];
+			from[kept] = from[i];
+			to[kept] = to[i];
+			progress[kept] = progress[i];
+			step[kept] = step[i];
+			running[k] = static_cast<uint32_t>(kept);
+		}
+		kept++;
+	}
+
+	entity.resize(kept);
+	channel.resize(kept);
+	curve.resize(kept);
+	from.resize(kept);
+	to.resize(kept);
+	progress.resize(kept);
+	step.resize(kept);
+}
+
+
+void TweenSystem::clear() {
+	entity.clear();
+	channel.clear();
+	curve.clear();
+	from.clear();
+	to.clear();
+	progress.clear();
+	step.clear();
+	running.clear();
+}
+
+
+void TweenSystem::reserve(size_t capacity) {
+	entity.reserve(capacity);
+	channel.reserve(capacity);
+	curve.reserve(capacity);
+	from.reserve(capacity);
+	to.reserve(capacity);
+	progress.reserve(capacity);
+	step.reserve(capacity);
+	value.reserve(capacity);
+	finished.reserve(capacity);
+	running.reserve(capacity * CHANNELS);
+}
+
+
+uint64_t TweenSystem::stateHash(uint64_t seed) const {
+	// running is rebuilt from the arrays by start() and update(), so only
+	// the arrays need hashing. EntityHandle is two uint32_t, no padding.
+	size_t n = size();
+	uint64_t h = xxHash64(entity.data(), n * sizeof(EntityHandle), seed);
+	h = xxHash64(channel.data(), n * sizeof(TweenChannel), h);
+	h = xxHash64(curve.data(), n * sizeof(EaseCurve), h);
+	h = xxHash64(from.data(), n * sizeof(float), h);
+	h = xxHash64(to.data(), n * sizeof(float), h);
+	h = xxHash64(progress.data(), n * sizeof(float), h);
+	return xxHash64(step.data(), n * sizeof(float), h);
+}
+
+
+uint32_t TweenSystem::find(EntityHandle entity_, TweenChannel channel_) const {
+	size_t k = key(entity_, channel_);
+	if (k >= running.size() || running[k] == NO_TWEEN) return NO_TWEEN;
+
+	// The slot may have been reused since, by an entity with a different
+	// generation whose channel isn't animated
+	uint32_t i = running[k];
+	return i < entity.size() && entity[i] == entity_ && channel[i] == channel_ ? i : NO_TWEEN;
+}
+
+
+size_t TweenSystem::key(EntityHandle entity_, TweenChannel channel_) const {
+	return static_cast<size_t>(entity_.slot) * CHANNELS + static_cast<size_t>(channel_);
+}
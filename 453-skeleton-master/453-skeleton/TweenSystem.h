@@ -0,0 +1,123 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Batched tweens: animates entity components from one value to another over
+// a number of ticks along an easing curve.
+//
+// Running tweens are stored as parallel arrays, not as objects per entity.
+// update() advances all of them in one pass that evaluates every curve
+// without branching on which curve a tween uses (each is a few
+// multiply-adds, so computing all of them and selecting is cheaper than a
+// branch per tween), writes the results into the EntityStore, then retires
+// every finished tween in a single compaction pass. Nothing is allocated per
+// tween, and entities with no tween running cost nothing per tick, so a
+// million diamonds can pop in at once.
+//
+// Each entity channel has at most one tween. Starting another one replaces
+// it; passing the channel's current value as from carries on smoothly.
+// Tweens whose entity is destroyed are retired on the next update().
+//
+// Durations are in simulation ticks, so tweens play back the same in
+// replays.
+//
+// Example:
+//		tweens.start(ship, TweenChannel::X, x, x + 0.1f, 4, EaseCurve::QuadOut);
+//		tweens.startMany(entities, 0, entities.size(), TweenChannel::Scale, 0.0f, 1.0f, 10, EaseCurve::BackOut);
+//		tweens.update(entities, jobs);
+//------------------------------------------------------------------------------
+
+#include "EntityStore.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+class JobSystem;
+
+
+enum class EaseCurve : uint8_t {
+	Linear,
+	QuadOut,		// fast start, slows into the end
+	CubicInOut,		// slow at both ends
+	SmoothStep,
+	BackOut			// overshoots the end a little and settles back
+};
+
+
+// The EntityStore component a tween writes to
+enum class TweenChannel : uint8_t {
+	X,
+	Y,
+	Scale,
+	Count
+};
+
+
+// The eased fraction for t in [0, 1]. Exactly 0 at t = 0 and 1 at t = 1 for
+// every curve.
+float ease(EaseCurve curve, float t);
+
+
+class TweenSystem {
+
+public:
+	TweenSystem();
+
+	// Animates channel of entity from `from` to `to` over ticks updates
+	// (at least 1), replacing any tween already running on that channel
+	void start(EntityHandle entity, TweenChannel channel, float from, float to, int ticks, EaseCurve curve);
+
+	// start() for the count entities at dense indices [first, first + count),
+	// sizing every array once and filling them in a single pass
+	void startMany(const EntityStore& entities, size_t first, size_t count, TweenChannel channel, float from, float to, int ticks, EaseCurve curve);
+
+	// The value channel will settle at: the end of its running tween, or
+	// current if there is none
+	float endValue(EntityHandle entity, TweenChannel channel, float current) const;
+
+	bool isRunning(EntityHandle entity, TweenChannel channel) const;
+
+	// Advances every tween one tick and writes the new values into
+	// entities. Finished tweens write their exact end value, then retire.
+	void update(EntityStore& entities, JobSystem& jobs);
+
+	void clear();
+	void reserve(size_t capacity);
+
+	size_t size() const { return entity.size(); }
+
+	// Calls f(index, channel) for every component the next update() will
+	// write, index being the entity's dense index
+	template <typename F>
+	void forEachTarget(const EntityStore& entities, F&& f) const {
+		for (size_t i = 0; i < size(); i++) {
+			if (entities.isAlive(entity[i])) f(entities.indexOf(entity[i]), channel[i]);
+		}
+	}
+
+	// Fingerprint of every running tween, for Simulation::stateHash()
+	uint64_t stateHash(uint64_t seed) const;
+
+private:
+	// One entry per running tween
+	std::vector<EntityHandle> entity;
+	std::vector<TweenChannel> channel;
+	std::vector<EaseCurve> curve;
+	std::vector<float> from;
+	std::vector<float> to;
+	std::vector<float> progress;	// in [0, 1]
+	std::vector<float> step;		// progress per tick, 1 / ticks
+
+	// Scratch space for update(), kept so updating doesn't allocate
+	std::vector<float> value;
+	std::vector<uint8_t> finished;
+
+	// entity slot * channel count + channel -> index of its running tween,
+	// or NO_TWEEN
+	std::vector<uint32_t> running;
+
+	// Index of the channel's running tween, or NO_TWEEN
+	uint32_t find(EntityHandle entity, TweenChannel channel) const;
+	size_t key(EntityHandle entity, TweenChannel channel) const;
+};
@@ -6,7 +6,36 @@
 VertexArray::VertexArray()
 	: arrayID{}
 {
+	// Without direct state access attributes are set up on whichever array
+	// is bound, and everything that makes one expects it to be this one
+	if (!GLState::get().hasDirectStateAccess()) bind();
+}
+
+
+void VertexArray::attachBuffer(GLuint index, GLuint buffer, GLint size, GLenum type, GLsizei stride, GLintptr offset) {
+	if (GLState::get().hasDirectStateAccess()) {
+		glVertexArrayVertexBuffer(arrayID, index, buffer, offset, stride);
+		glVertexArrayAttribFormat(arrayID, index, size, type, GL_FALSE, 0);
+		glVertexArrayAttribBinding(arrayID, index, index);
+		glEnableVertexArrayAttrib(arrayID, index);
+		return;
+	}
+
+	bind();
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glVertexAttribPointer(index, size, type, GL_FALSE, stride, (void*)offset);
+	glEnableVertexAttribArray(index);
+}
+
+
+void VertexArray::setDivisor(GLuint index, GLuint divisor) {
+	if (GLState::get().hasDirectStateAccess()) {
+		glVertexArrayBindingDivisor(arrayID, index, divisor);
+		return;
+	}
+
 	bind();
+	glVertexAttribDivisor(index, divisor);
 }
 
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "GLState.h"
 
 #include <GL/glew.h>
 
@@ -18,7 +19,18 @@ public:
 	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
 
 	// Public interface
-	void bind() const { glBindVertexArray(arrayID); }
+	void bind() const { GLState::get().bindVertexArray(arrayID); }
+
+	// Attribute index reads size components of type from buffer, starting
+	// at offset and stride bytes apart. Enables the attribute. Each
+	// attribute reads through the vertex buffer binding of the same index.
+	void attachBuffer(GLuint index, GLuint buffer, GLint size, GLenum type, GLsizei stride, GLintptr offset = 0);
+
+	// Attribute index advances once every divisor instances instead of
+	// once per vertex (0)
+	void setDivisor(GLuint index, GLuint divisor);
+
+	GLuint getID() const { return arrayID.value(); }
 
 private:
 	VertexArrayHandle arrayID;
@@ -1,18 +1,73 @@
 #include "VertexBuffer.h"
 
+#include "GLState.h"
+
 #include <utility>
 
 
-VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType)
+namespace {
+
+	GLsizei bytesPerComponent(GLenum dataType) {
+		switch (dataType) {
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_HALF_FLOAT:
+			return 2;
+		case GL_DOUBLE:
+			return 8;
+		default:
+			return 4;
+		}
+	}
+}
+
+
+VertexBuffer::VertexBuffer(VertexArray& vao, GLuint index, GLint size, GLenum dataType)
+	: VertexBuffer(vao, { { index, size, dataType, size * bytesPerComponent(dataType), 0 } })
+{}
+
+
+VertexBuffer::VertexBuffer(VertexArray& vao, const std::vector<VertexAttributeFormat>& attributes)
 	: bufferID{}
+	, arrayID(vao.getID())
+	, attributes(attributes)
+	, storage(0)
 {
-	bind();
-	glVertexAttribPointer(index, size, dataType, GL_FALSE, 0, (void*)0);
-	glEnableVertexAttribArray(index);
+	for (const VertexAttributeFormat& a : attributes) {
+		vao.attachBuffer(a.index, bufferID, a.size, a.type, a.stride, a.offset);
+	}
 }
 
 
 void VertexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
-	bind();
-	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+	if (!GLState::get().hasDirectStateAccess()) {
+		bind();
+		glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+		return;
+	}
+
+	if (size <= storage) {
+		glNamedBufferSubData(bufferID, 0, size, data);
+		return;
+	}
+
+	// The buffer made in the constructor is already attached and has no
+	// storage yet, so the first upload gives it some
+	if (storage == 0) {
+		storage = size;
+		glNamedBufferStorage(bufferID, size, data, GL_DYNAMIC_STORAGE_BIT);
+		return;
+	}
+
+	// Immutable storage can't grow, so the data goes into a new buffer that
+	// takes the old one's place in the vertex array
+	bufferID = VertexBufferHandle();
+	storage = size;
+	glNamedBufferStorage(bufferID, size, data, GL_DYNAMIC_STORAGE_BIT);
+	for (const VertexAttributeFormat& a : attributes) {
+		glVertexArrayVertexBuffer(arrayID, a.index, bufferID, a.offset, a.stride);
+	}
 }
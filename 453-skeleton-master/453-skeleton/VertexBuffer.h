@@ -1,14 +1,34 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "VertexArray.h"
 
 #include <GL/glew.h>
 
+#include <vector>
+
+
+// Where one attribute is in a vertex buffer: location index reads size
+// components of type, offset bytes into each stride bytes
+struct VertexAttributeFormat {
+	GLuint index;
+	GLint size;
+	GLenum type;
+	GLsizei stride;
+	GLintptr offset;
+};
+
 
 class VertexBuffer {
 
 public:
-	VertexBuffer(GLuint index, GLint size, GLenum dataType);
+	// Attribute index of vao reads size components of dataType per vertex
+	// from this buffer
+	VertexBuffer(VertexArray& vao, GLuint index, GLint size, GLenum dataType);
+
+	// Every one of attributes reads from this buffer, e.g. the interleaved
+	// attributes of a VertexLayout
+	VertexBuffer(VertexArray& vao, const std::vector<VertexAttributeFormat>& attributes);
 
 	// Because we're using the VertexBufferHandle to do RAII for the buffer for us
 	// and our other types are trivial or provide their own RAII
@@ -19,9 +39,18 @@ public:
 
 	// Public interface
 	void bind() const { glBindBuffer(GL_ARRAY_BUFFER, bufferID); }
+
+	// With direct state access the data goes into immutable storage and
+	// usage is ignored. The first upload sizes the storage, uploads that fit
+	// overwrite it in place, and bigger ones replace the buffer with a new one.
 	void uploadData(GLsizeiptr size, const void* data, GLenum usage);
 
 private:
 	VertexBufferHandle bufferID;
-};
 
+	// Where the buffer is attached, to attach a replacement
+	GLuint arrayID;
+	std::vector<VertexAttributeFormat> attributes;
+
+	GLsizeiptr storage;		// bytes of immutable storage, 0 before the first upload
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Vertex formats described as a list of attribute types, with strides and
+// offsets worked out at compile time.
+//
+// VertexLayout<Position3f, TexCoord2f> is a vertex of a position followed by
+// a texture coordinate. Attribute i of the layout is read from location
+// firstIndex + i (0 by default), so the order of the list is the order of
+// the `layout (location = ...)` inputs of the vertex shader.
+//
+// A layout can describe one interleaved buffer (every attribute of a vertex
+// next to each other, the default) or separate streams, one buffer per
+// attribute. Interleaved is better for vertex fetch: a vertex's attributes
+// share cache lines. Separate streams suit attributes that change on their
+// own, since one can be uploaded without touching the others.
+//
+// New attribute types derive from VertexAttribute with the CPU type they are
+// stored as.
+//
+// Example:
+//		using SpriteVertex = VertexLayout<Position3f, TexCoord2f>;
+//		VertexBuffer buffer(vao, SpriteVertex::interleaved());
+//		SpriteVertex::interleave(bytes, positions, texCoords);
+//		buffer.uploadData(bytes.size(), bytes.data(), GL_STATIC_DRAW);
+//------------------------------------------------------------------------------
+
+#include "VertexBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+
+template <typename T, GLint Components, GLenum Type>
+struct VertexAttribute {
+	using Value = T;
+	static constexpr GLint COMPONENTS = Components;
+	static constexpr GLenum TYPE = Type;
+};
+
+struct Position2f : VertexAttribute<glm::vec2, 2, GL_FLOAT> {};
+struct Position3f : VertexAttribute<glm::vec3, 3, GL_FLOAT> {};
+struct TexCoord2f : VertexAttribute<glm::vec2, 2, GL_FLOAT> {};
+struct Normal3f : VertexAttribute<glm::vec3, 3, GL_FLOAT> {};
+struct Color3f : VertexAttribute<glm::vec3, 3, GL_FLOAT> {};
+struct Color4f : VertexAttribute<glm::vec4, 4, GL_FLOAT> {};
+
+
+enum class VertexStorage {
+	Interleaved,	// one buffer, attributes of a vertex side by side
+	Separate		// one buffer per attribute
+};
+
+
+// Running totals of sizes, starting at 0
+template <size_t N>
+constexpr std::array<GLintptr, N> vertexOffsets(const std::array<GLsizei, N>& sizes) {
+	std::array<GLintptr, N> offsets = {};
+	GLintptr offset = 0;
+	for (size_t i = 0; i < N; i++) {
+		offsets[i] = offset;
+		offset += sizes[i];
+	}
+	return offsets;
+}
+
+
+template <typename... Attributes>
+class VertexLayout {
+
+public:
+	static constexpr size_t COUNT = sizeof...(Attributes);
+	static_assert(COUNT > 0, "A vertex needs at least one attribute");
+
+	static constexpr std::array<GLint, COUNT> COMPONENTS = { Attributes::COMPONENTS... };
+	static constexpr std::array<GLenum, COUNT> TYPES = { Attributes::TYPE... };
+	static constexpr std::array<GLsizei, COUNT> SIZES = { static_cast<GLsizei>(sizeof(typename Attributes::Value))... };
+
+	// Bytes from one interleaved vertex to the next
+	static constexpr GLsizei STRIDE = (0 + ... + static_cast<GLsizei>(sizeof(typename Attributes::Value)));
+
+	// Where each attribute starts in an interleaved vertex
+	static constexpr std::array<GLintptr, COUNT> OFFSETS = vertexOffsets(SIZES);
+
+	// The formats of every attribute when interleaved in one buffer
+	static std::vector<VertexAttributeFormat> interleaved(GLuint firstIndex = 0) {
+		std::vector<VertexAttributeFormat> formats;
+		for (size_t i = 0; i < COUNT; i++) {
+			formats.push_back({ firstIndex + static_cast<GLuint>(i), COMPONENTS[i], TYPES[i], STRIDE, OFFSETS[i] });
+		}
+		return formats;
+	}
+
+	// The format of attribute i alone in a buffer of its own
+	static std::vector<VertexAttributeFormat> separate(size_t i, GLuint firstIndex = 0) {
+		return { { firstIndex + static_cast<GLuint>(i), COMPONENTS[i], TYPES[i], SIZES[i], 0 } };
+	}
+
+	// Writes the streams (one per attribute, all the same length) into out
+	// as interleaved vertices
+	static void interleave(std::vector<unsigned char>& out, const std::vector<typename Attributes::Value>&... streams) {
+		const size_t lengths[COUNT] = { streams.size()... };
+		size_t count = lengths[0];
+		for (size_t length : lengths) {
+			if (length != count) throw std::runtime_error("Vertex attribute streams have different lengths");
+		}
+
+		out.resize(count * STRIDE);
+		size_t i = 0;
+		(copyStream(out, streams, OFFSETS[i++]), ...);
+	}
+
+private:
+	template <typename T>
+	static void copyStream(std::vector<unsigned char>& out, const std::vector<T>& stream, GLintptr offset) {
+		unsigned char* vertex = out.data() + offset;
+		for (const T& value : stream) {
+			std::memcpy(vertex, &value, sizeof(T));
+			vertex += STRIDE;
+		}
+	}
+};
@@ -1,5 +1,6 @@
 #include "Window.h"
 
+#include "FlightRecorder.h"
 #include "Log.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
@@ -14,24 +15,28 @@
 
 void Window::keyMetaCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
 	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
+	FlightRecorder::get().recordInput("key", key, action);
 	callbacks->keyCallback(key, scancode, action, mods);
 }
 
 
 void Window::mouseButtonMetaCallback(GLFWwindow* window, int button, int action, int mods) {
 	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
+	FlightRecorder::get().recordInput("mouse_button", button, action);
 	callbacks->mouseButtonCallback(button, action, mods);
 }
 
 
 void Window::cursorPosMetaCallback(GLFWwindow* window, double xpos, double ypos) {
 	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
+	FlightRecorder::get().recordInput("cursor", static_cast<int>(xpos), static_cast<int>(ypos));
 	callbacks->cursorPosCallback(xpos, ypos);
 }
 
 
 void Window::scrollMetaCallback(GLFWwindow* window, double xoffset, double yoffset) {
 	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
+	FlightRecorder::get().recordInput("scroll", static_cast<int>(xoffset), static_cast<int>(yoffset));
 	callbacks->scrollCallback(xoffset, yoffset);
 }
 
@@ -52,16 +57,24 @@ Window::Window(
 )
 	: window(nullptr)
 	, callbacks(callbacks)
+	, glMajor(0)
+	, glMinor(0)
 {
 	// specify OpenGL version
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // needed for mac?
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 
-	// create window
-	window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, monitor, share));
+	// create window. 4.3 adds compute shaders (see GpuSimulation) and 4.5
+	// direct state access (see GLState); where neither is available (e.g.
+	// macOS) fall back to the 3.3 everything else needs
+	const int VERSIONS[][2] = { { 4, 5 }, { 4, 3 }, { 3, 3 } };
+	for (const auto& version : VERSIONS) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+		window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, monitor, share));
+		if (window != nullptr) break;
+	}
 	if (window == nullptr) {
 		Log::error("WINDOW failed to create GLFW window");
 		throw std::runtime_error("Failed to create GLFW window.");
@@ -75,6 +88,10 @@ Window::Window(
 		throw std::runtime_error("Failed to initialize GLEW");
 	}
 
+	glGetIntegerv(GL_MAJOR_VERSION, &glMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &glMinor);
+	Log::info("WINDOW created an OpenGL {}.{} context", glMajor, glMinor);
+
 	glfwSetWindowSizeCallback(window.get(), defaultWindowSizeCallback);
 
 	if (callbacks != nullptr) {
@@ -59,6 +59,10 @@ public:
 	int getWidth() const { return getSize().x; }
 	int getHeight() const { return getSize().y; }
 
+	// Whether the context is GL 4.3 or newer, so compute shaders and shader
+	// storage buffers can be used
+	bool hasComputeShaders() const { return glMajor > 4 || (glMajor == 4 && glMinor >= 3); }
+
 	int shouldClose() { return glfwWindowShouldClose(window.get()); }
 	void makeContextCurrent() { glfwMakeContextCurrent(window.get()); }
 	void swapBuffers() { glfwSwapBuffers(window.get()); }
@@ -66,6 +70,8 @@ public:
 private:
 	std::unique_ptr<GLFWwindow, WindowDeleter> window; // owning ptr (from GLFW)
 	std::shared_ptr<CallbackInterface> callbacks;      // optional shared owning ptr (user provided)
+	GLint glMajor;
+	GLint glMinor;
 
 	void connectCallbacks();
 
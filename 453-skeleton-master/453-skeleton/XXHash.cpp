@@ -0,0 +1,109 @@
+#include "XXHash.h"
+
+#include <cstring>
+
+
+namespace {
+
+	const uint64_t PRIME1 = 11400714785074694791ull;
+	const uint64_t PRIME2 = 14029467366897019727ull;
+	const uint64_t PRIME3 = 1609587929392839161ull;
+	const uint64_t PRIME4 = 9650029242287828579ull;
+	const uint64_t PRIME5 = 2870177450012600261ull;
+
+	inline uint64_t rotl(uint64_t x, int r) {
+		return (x << r) | (x >> (64 - r));
+	}
+
+	// Reads are little endian, as in the reference implementation, so the
+	// same state hashes the same everywhere. memcpy compiles to a single
+	// (unaligned) load; only big endian hosts need to swap the bytes.
+	inline uint64_t read64(const uint8_t* p) {
+		uint64_t v;
+		std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		v = __builtin_bswap64(v);
+#endif
+		return v;
+	}
+
+	inline uint32_t read32(const uint8_t* p) {
+		uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		v = __builtin_bswap32(v);
+#endif
+		return v;
+	}
+
+	inline uint64_t round(uint64_t acc, uint64_t input) {
+		acc += input * PRIME2;
+		acc = rotl(acc, 31);
+		return acc * PRIME1;
+	}
+
+	inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+		acc ^= round(0, val);
+		return acc * PRIME1 + PRIME4;
+	}
+}
+
+
+uint64_t xxHash64(const void* data, size_t size, uint64_t seed) {
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	const uint8_t* end = p + size;
+	uint64_t h;
+
+	if (size >= 32) {
+		// Four independent lanes over 32 byte stripes
+		uint64_t v1 = seed + PRIME1 + PRIME2;
+		uint64_t v2 = seed + PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME1;
+
+		const uint8_t* limit = end - 32;
+		do {
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = mergeRound(h, v1);
+		h = mergeRound(h, v2);
+		h = mergeRound(h, v3);
+		h = mergeRound(h, v4);
+	}
+	else {
+		h = seed + PRIME5;
+	}
+
+	h += static_cast<uint64_t>(size);
+
+	// Remaining 0-31 bytes
+	while (p + 8 <= end) {
+		h ^= round(0, read64(p));
+		h = rotl(h, 27) * PRIME1 + PRIME4;
+		p += 8;
+	}
+	if (p + 4 <= end) {
+		h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+		h = rotl(h, 23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+	while (p < end) {
+		h ^= static_cast<uint64_t>(*p) * PRIME5;
+		h = rotl(h, 11) * PRIME1;
+		p++;
+	}
+
+	// Avalanche
+	h ^= h >> 33;
+	h *= PRIME2;
+	h ^= h >> 29;
+	h *= PRIME3;
+	h ^= h >> 32;
+	return h;
+}
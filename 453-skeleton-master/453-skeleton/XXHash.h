@@ -0,0 +1,16 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// 64 bit xxHash (XXH64, https://github.com/Cyan4973/xxHash).
+//
+// A fast non-cryptographic hash, used to fingerprint simulation state every
+// tick. Runs at several GB/s, so hashing every component array of a few
+// thousand entities costs microseconds. The output matches the reference
+// implementation for the same input and seed, on any platform.
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+
+
+uint64_t xxHash64(const void* data, size_t size, uint64_t seed = 0);
@@ -1,14 +1,29 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
-#include "Geometry.h"
+#include "FlightRecorder.h"
 #include "GLDebug.h"
+#include "GLHandles.h"
+#include "GLState.h"
+#include "GpuSimulation.h"
+#include "InputEvent.h"
+#include "JobSystem.h"
 #include "Log.h"
+#include "ParticleSystem.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include "Replay.h"
 #include "ShaderProgram.h"
 #include "Shader.h"
+#include "Simulation.h"
+#include "SimulationThread.h"
 #include "Texture.h"
 #include "Window.h"
 
@@ -16,653 +31,498 @@
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
+#include <argh.h>
 
-// An example struct for Game Objects.
-// You are encouraged to customize this as you see fit.
-struct GameObject {
-	// Struct's constructor deals with the texture.
-	// Also sets default position, theta, scale, and transformationMatrix
-	GameObject(std::string texturePath, GLenum textureInterpolation) :
-		texture(texturePath, textureInterpolation),
-		position(0.0f, 0.0f, 0.0f),
-		transformationMatrix(1.0f) // This constructor sets it as the identity matrix
-	{}
-
-	CPU_Geometry cgeom;
-	GPU_Geometry ggeom;
-	Texture texture;
-
-    float v1, v2, theta, scaling_factor, target_theta, target_v1, target_v2;
-    glm::vec3 direction;
-
-	glm::vec3 position;
-	glm::mat4 transformationMatrix;
-};
 
 /*
 
-Struct used to keep track of states changed by callbacks. The mouse coordinates are used by the rotation functionality and the up pressed and down pressed is for the translations. Reset is used for when a player hits the j key and the entire game is reset. The functions stateChanged and stateReset are used in the render loop. They check the state of user input and reset default bools respectively.
-
-*/
-struct State {
-    glm::vec2 mouse_coordinates;
-    bool state_changed = true;
-    bool mouse_clicked = false;
-    bool up_pressed = false;
-    bool reset = false;
-    bool down_pressed = false;
-
-    bool stateChanged()
-    {
-        if (mouse_clicked == true || down_pressed == true || up_pressed == true) return true;
-        else return false;
-    }
-
-    void stateReset()
-    {
-        bool state_changed = false;
-        bool mouse_clicked = false;
-        bool up_pressed = false;
-        bool reset = false;
-        bool down_pressed = false;
-    }
-};
-
-/*
-
-The callbacks are how the user is able to interact with the game. The up key and down key will move the player along the direction vector they currently are on. A mouse click will change the direction vector of the player and the j key will reset the game to default values. All these values are kept track of using a State struct which tracks the coordinates of the mouse as well as whether the up and down keys are being held down. 
+The callbacks are how the user is able to interact with the game. The up key and down key will move the player along the direction vector they currently are on. A mouse click will change the direction vector of the player and the j key will reset the game to default values. Every one of these is pushed as a timestamped InputEvent onto the input queue, which the simulation thread drains once per tick, so no click or key press is lost between ticks. The mouse coordinates are converted to normalized device coordinates here since only the callbacks know the screen size.
 
 */
 class MyCallbacks : public CallbackInterface {
 
 public:
-    MyCallbacks(ShaderProgram &shader, int screen_width, int screen_height) : shader(shader), screen_dimensions(screen_width, screen_height){ }
+    MyCallbacks(ShaderProgram &shader, InputQueue &input, int screen_width, int screen_height) : shader(shader), input(input), screen_dimensions(screen_width, screen_height), mouse_coordinates(0.0f), dropped_events(0) { }
 
 	virtual void keyCallback(int key, int scancode, int action, int mods) {
 		if (key == GLFW_KEY_R && action == GLFW_PRESS) {
 			shader.recompile();
 		}
 
-        if (key == GLFW_KEY_UP && action == GLFW_PRESS)
-        {
-            state.up_pressed = true;
-            state.state_changed = true;
-        }
-
-        if (key == GLFW_KEY_DOWN && action == GLFW_PRESS)
-        {
-            state.down_pressed = true;
-            state.state_changed = true;
-        }
-
-        if (key == GLFW_KEY_UP && action == GLFW_RELEASE)
-        {
-            state.up_pressed = false;
-            state.state_changed = true;
-        }
-
-        if (key == GLFW_KEY_DOWN && action == GLFW_RELEASE)
-        {
-            state.down_pressed = false;
-            state.state_changed = true;
-        }
-
-        if (key == GLFW_KEY_J && action == GLFW_PRESS)
-        {
-            state.reset = true;
-        }
-
-        if (key == GLFW_KEY_J && action == GLFW_RELEASE)
-        {
-            state.reset = false;
-        }
+        if (key == GLFW_KEY_UP && action == GLFW_PRESS) push(InputEventType::ForwardPressed);
+        if (key == GLFW_KEY_UP && action == GLFW_RELEASE) push(InputEventType::ForwardReleased);
+        if (key == GLFW_KEY_DOWN && action == GLFW_PRESS) push(InputEventType::BackwardPressed);
+        if (key == GLFW_KEY_DOWN && action == GLFW_RELEASE) push(InputEventType::BackwardReleased);
+        if (key == GLFW_KEY_J && action == GLFW_PRESS) push(InputEventType::Reset);
     }
 
     virtual void mouseButtonCallback(int button, int action, int mods)
     {
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
         {
-            state.mouse_clicked = true;
-            state.state_changed = true;
+            push(InputEventType::TurnToward);
         }
     }
 
     virtual void cursorPosCallback(double xpos, double ypos)
     {
-        state.mouse_coordinates = glm::vec2(xpos, ypos);
-        state.mouse_coordinates = state.mouse_coordinates / (screen_dimensions - 1.0f);
-        state.mouse_coordinates *= 2;
-        state.mouse_coordinates -= 1;
-        state.mouse_coordinates.y = -state.mouse_coordinates.y;
-    }
-
-    void stateHandled()
-    {
-        state.mouse_clicked = false;
-    }
-
-    const State& getState()
-    {
-        return state;
+        mouse_coordinates = glm::vec2(xpos, ypos);
+        mouse_coordinates = mouse_coordinates / (screen_dimensions - 1.0f);
+        mouse_coordinates *= 2;
+        mouse_coordinates -= 1;
+        mouse_coordinates.y = -mouse_coordinates.y;
     }
 
 private:
 	ShaderProgram& shader;
-    State state;
+    InputQueue& input;
     glm::vec2 screen_dimensions;
-};
-
-/*
-
-These are the positional coordinates of every object initialised in the game before they've been changed by the matrices of the vertex shader.
+    glm::vec2 mouse_coordinates;
+    size_t dropped_events;
 
-*/
+    void push(InputEventType type)
+    {
+        InputEvent event;
+        event.timeNs = FlightRecorder::get().now();
+        event.type = type;
+        event.position = mouse_coordinates;
 
-CPU_Geometry objectGeom() {
-
-	CPU_Geometry retGeom;
- 
-	// For full marks (Part IV), you'll need to use the following vertex coordinates instead.
-	// Then, you'd get the correct scale/translation/rotation by passing in uniforms into
-	// the vertex shader.
-
-    retGeom.verts.push_back(glm::vec3(-1.f , 1.f , 1.f));
-    retGeom.verts.push_back(glm::vec3(-1.f, -1.f, 1.f));
-    retGeom.verts.push_back(glm::vec3(1.f, -1.f, 1.f));
-    retGeom.verts.push_back(glm::vec3(-1.f, 1.f, 1.f));
-    retGeom.verts.push_back(glm::vec3(1.f, -1.f, 1.f));
-    retGeom.verts.push_back(glm::vec3(1.f, 1.f, 1.f));
-
-    // texture coordinates
-	retGeom.texCoords.push_back(glm::vec2(0.f, 1.f));
-	retGeom.texCoords.push_back(glm::vec2(0.f, 0.f));
-	retGeom.texCoords.push_back(glm::vec2(1.f, 0.f));
-	retGeom.texCoords.push_back(glm::vec2(0.f, 1.f));
-	retGeom.texCoords.push_back(glm::vec2(1.f, 0.f));
-	retGeom.texCoords.push_back(glm::vec2(1.f, 1.f));
-	return retGeom;
-}
+        // The queue only fills up if the simulation stops draining it
+        if (!input.tryPush(event) && dropped_events++ == 0)
+        {
+            Log::warn("INPUT queue full, dropping events");
+        }
+    }
+};
 
 /*
 
-This function generates a random float value to be used for the positional coordinates of our player. The floats it produces are between -1 and 1.
+Everything that used to be hard-coded in main and that is worth changing between runs without a recompile. Entities counts the ship too, so the default of 5 is the ship and 4 diamonds. A seed of 0 picks one from the clock and a thread count of 0 uses one thread per core; 1 runs every job inline on the simulation thread. Particles is how many exhaust and explosion particles the GPU keeps at most. GPU sim moves the whole simulation into compute shaders for scenes too big for the CPU; it needs OpenGL 4.3 and falls back to the CPU without it. Cull has the GPU work out which of the GPU simulation's sprites are on screen so only those are drawn, also only with OpenGL 4.3; the CPU simulation's snapshots are always culled on the CPU. Stats shows an overlay with the frame time and what the last frame cost the GPU in draw calls, state changes, uniform updates and uploads. DSA creates and edits buffers, textures and vertex arrays by name where OpenGL 4.5 allows it; turning it off uses the older bind-to-edit calls. With bench frames set the game quits after that many frames (or ticks when headless) and logs how long they took. Headless runs the simulation without a window, as fast as it goes, and replays are always headless.
 
 */
-float makeRandom()
-{
-    int random = rand() % 600;
-    if (random % 2 == 0) random *= -1;
-    float randomAdjustor = (float)(random) / 600;
-
-    return randomAdjustor;
-}
-
-/*
-
-Works in concert with makeRandom to produce a random float. All this function does is make sure the output from makeRandom is within a certain range. The range will be -x to x.
+struct Config {
+    int width = 800;
+    int height = 800;
+    bool vsync = true;
+    bool headless = false;
+    int entities = 5;
+    uint32_t seed = 0;
+    unsigned threads = 0;
+    int bench_frames = 0;
+    int particles = 1 << 20;
+    bool gpu_sim = false;
+    bool cull = true;
+    bool stats = false;
+    bool dsa = true;
+    std::string replay;
+    std::string record = "last_session.replay";
+};
 
-*/
-float keepWithin(float x)
+const char* USAGE =
+    "usage: 453-skeleton [options]\n"
+    "  --width N, --height N   window size (800x800)\n"
+    "  --vsync 0|1             wait for vertical sync (1)\n"
+    "  --headless              simulate without a window, as fast as possible\n"
+    "  --entities N            ship plus diamonds (5)\n"
+    "  --seed N                random seed (0 = from the clock)\n"
+    "  --threads N             simulation threads (0 = one per core, 1 = inline)\n"
+    "  --bench-frames N        quit after N frames and log frame times\n"
+    "  --particles N           most exhaust and explosion particles alive at once (1048576)\n"
+    "  --gpu-sim               simulate on the GPU with compute shaders (needs OpenGL 4.3)\n"
+    "  --cull 0|1              skip off-screen GPU simulation sprites on the GPU (1, needs OpenGL 4.3)\n"
+    "  --stats                 show frame time and render counters\n"
+    "  --dsa 0|1               create and edit GL objects without binding them (1, needs OpenGL 4.5)\n"
+    "  --replay FILE           play a recorded session back, headless\n"
+    "  --record FILE           where to save this session (last_session.replay)\n";
+
+Config parseConfig(int argc, char* argv[])
 {
-    float randomFloat = makeRandom();
-    while(randomFloat > x || randomFloat < -x)
-    {
-        randomFloat = makeRandom();
-    }
-
-    return randomFloat;
+    argh::parser cmdl(argc, argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+
+    Config config;
+    cmdl("width", config.width) >> config.width;
+    cmdl("height", config.height) >> config.height;
+    int vsync = config.vsync ? 1 : 0;
+    cmdl("vsync", vsync) >> vsync;
+    config.vsync = vsync != 0;
+    config.headless = cmdl["headless"];
+    cmdl("entities", config.entities) >> config.entities;
+    cmdl("seed", config.seed) >> config.seed;
+    cmdl("threads", config.threads) >> config.threads;
+    cmdl("bench-frames", config.bench_frames) >> config.bench_frames;
+    cmdl("particles", config.particles) >> config.particles;
+    config.gpu_sim = cmdl["gpu-sim"];
+    int cull = config.cull ? 1 : 0;
+    cmdl("cull", cull) >> cull;
+    config.cull = cull != 0;
+    config.stats = cmdl["stats"];
+    int dsa = config.dsa ? 1 : 0;
+    cmdl("dsa", dsa) >> dsa;
+    config.dsa = dsa != 0;
+    cmdl("replay", config.replay) >> config.replay;
+    cmdl("record", config.record) >> config.record;
+
+    config.width = std::max(config.width, 1);
+    config.height = std::max(config.height, 1);
+    config.entities = std::max(config.entities, 2);
+    config.bench_frames = std::max(config.bench_frames, 0);
+    config.particles = std::max(config.particles, 1);
+    if (config.seed == 0) config.seed = static_cast<uint32_t>(time(NULL));
+    return config;
 }
 
 /*
 
-This function will return a unit vector of the same direction as the vector vector_in it takes as input. Does so by finding the magnitude of the input vector and dividing the x and y values by the reciprocal of this. We ignore the z because as a 2d vector we already know it to be 0.
+Logs the mean and a few percentiles of a list of frame (or tick) times in milliseconds.
 
 */
-glm::vec3 makeUnitVector(glm::vec3 vector_in)
+void logTimings(const char* what, std::vector<double> ms)
 {
-    float magnitude = sqrt(vector_in.x * vector_in.x + vector_in.y * vector_in.y);
-    return glm::vec3((vector_in.x / magnitude),(vector_in.y / magnitude), 0.0f);
+    if (ms.empty()) return;
+    std::sort(ms.begin(), ms.end());
+    double total = 0.0;
+    for (double m : ms) total += m;
+
+    auto at = [&](double p) { return ms[std::min(ms.size() - 1, static_cast<size_t>(p * ms.size()))]; };
+    Log::info("BENCH {} {}: mean {:.3f} ms, p50 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms",
+        ms.size(), what, total / ms.size(), at(0.5), at(0.99), ms.back());
 }
 
-/*
-
-This function finds the appropriate rotation to point the player (ship) towards the mouse click. It first makes a unit vector for where it should be pointing (ie. the new direction vector for the player) and the standard north pointing vector. We then check if the new direction is different from the current one, if it isn't we continue, otherwise we end the function. The dot product of the two vectors (current direction and new direction) is then found and we use this to find angle theta between them. We then account for the previous direction and add this to the angle between the vectors and we have our new theta. Depending on whether the click is to the right or left of the current direction (whether we're rotating clockwise or anticlockwise) we need to do different things and that's why we have an if of or_1. This is the cross product which we use to tell which vector is on the right of the other in the clockwise direction. 
-
-*/
-float findRotationTheta(State state, GameObject& ship)
+int runReplay(const Config& config)
 {
-    glm::vec3 new_direction = glm::vec3(state.mouse_coordinates.x - ship.v1, state.mouse_coordinates.y - ship.v2, 0.0f);
-    new_direction = makeUnitVector(new_direction);
-
-    glm::vec3 standard = glm::vec3(0.0f, 1.0f, 0.0f);
-
-    if (new_direction == ship.direction)
+    try
     {
-        return ship.target_theta;
-    }
-    else
-    {
-        double dot1 = ship.direction.x * new_direction.x + ship.direction.y * new_direction.y;
-        double theta1 = acos(dot1);
-        double dot2 = standard.x * ship.direction.x + standard.y * ship.direction.y;
-        double theta2 = acos(dot2);
-        double or_1 = ship.direction.x * -new_direction.y + ship.direction.y * new_direction.x;
-        double or_2 = standard.x * -ship.direction.y + standard.y * ship.direction.x;
-
-        if (or_1 > 0)
+        Replay replay = Replay::load(config.replay);
+        JobSystem jobs(config.threads);
+        ReplayResult result = playReplay(replay, jobs);
+        Log::info("REPLAY {} ticks in {:.3f}s ({:.0f}x real time), score {}{}",
+            result.ticks, result.seconds, (result.ticks / 60.0) / std::max(result.seconds, 1e-9),
+            result.score, result.won ? " (won)" : "");
+
+        if (result.firstDivergentTick != 0)
         {
-            if (standard.x > ship.direction.x)
-            {
-                theta2 = 2 * M_PI - theta2;
-            }
-
-            ship.direction = new_direction;
-            return theta1 + theta2;
+            Log::error("REPLAY is not deterministic: first divergent tick {} of {}", result.firstDivergentTick, result.ticksVerified);
+            return 1;
         }
-        else 
+        if (result.ticksVerified == 0 || result.ticksVerified < result.ticks)
         {
-            double theta;
-
-            if (or_2 < 0)
-            {
-                theta = theta2 + theta1;
-                theta = 2 * M_PI - theta;
-            }
-            else
-            {
-                theta = theta2 - theta1;
-            }
-
-            ship.direction = new_direction;
-            return theta;
+            Log::error("REPLAY only {} of {} ticks have a recorded state hash to check", result.ticksVerified, result.ticks);
+            return 1;
         }
+        Log::info("REPLAY state hashes match for all {} recorded ticks", result.ticksVerified);
+        return 0;
+    }
+    catch (std::runtime_error &e)
+    {
+        Log::error("REPLAY {}", e.what());
+        return 1;
     }
 }
 
 /*
 
-This is used to detect a close enough threshold to where two angles can be treated as equal. Its used to check if our target angle and current angle are close enough yet. This is an essential function for creating the animation type effect of the rotation.
-
-*/
-bool notCloseEnoughAngle(float a, float b)
-{
-    if (a < b + 0.005f && a > b - 0.005f) return false;
-    else return true;
-}
-
-/*
-
-This is used to detect a close enough threshold to where two coordinates can be treated as equal. Its used to check if our target position and current position are close enough yet. This is an essential function for creating the animation type effect of the translation.
-
-*/
-bool notCloseEnoughPosition(float a, float b)
-{
-    if (a < b + 0.00005f && a > b - 0.00005f) return false;
-    else return true;
-}
-
-/*
-
-Is used to move our ship along a particular direction vector by a magnitude decided by us. By multiplying the magnitude by the unit direction vector we have moved along the vector by a certain amount of units. This is then added or subtracted to the positions of the ship to produce forward and backward movement respectively.
+Runs the simulation on this thread with no input and no window, as fast as it goes. Mostly useful for timing the simulation with --entities and --threads.
 
 */
-std::tuple<float, float> moveShip(GameObject& ship)
+int runHeadless(const Config& config)
 {
-    float magnitude = 0.005f;
-    return std::tuple<float, float>{ship.direction.x * magnitude, ship.direction.y * magnitude};
-}
+    int ticks = config.bench_frames > 0 ? config.bench_frames : 600;
 
-/*
+    JobSystem jobs(config.threads);
+    Simulation simulation(jobs, config.entities - 1, config.seed);
 
-Finds the distance between two points by forming a vector between them and working out the magnitude of said vector.
+    std::vector<double> tick_ms;
+    tick_ms.reserve(ticks);
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        simulation.update();
+        tick_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
 
-*/
-float distanceBetween(GameObject& a, GameObject& b)
-{
-    float x = b.v1 - a.v1;
-    float y = b.v2 - a.v2;
-    float magnitude = sqrt(x * x + y * y);
-    return magnitude;
+    logTimings("ticks", tick_ms);
+    Log::info("HEADLESS seed {}, score {}, state hash {:016x}", config.seed, simulation.getScore(), simulation.stateHash());
+    return 0;
 }
 
 /*
 
-Checks whether two objects in our game are close enough to one another. The enough being decided to be 0.25 units.
+Plays the game in window until it is closed. Everything that owns GL objects is a local in here, so all of it is deleted by the time this returns, while the context still exists.
 
 */
-bool withinOrbit(GameObject& ship, GameObject& diamond)
+int runGame(Window& window, const Config& config)
 {
-    if (distanceBetween(ship, diamond) < 0.25) return true;
-    return false;
-}
-
-int main() {
-	Log::debug("Starting main");
+    int screen_width = config.width;
+    int screen_height = config.height;
+    int diamond_count = config.entities - 1;
 
-    int screen_width = 800;
-    int screen_height = 800;
-
-	// WINDOW
-	glfwInit();
-	Window window(screen_width, screen_height, "CPSC 453 Assignment 2"); // can set callbacks at construction if desired
-
-    // SEEDING RAND
-    srand(time(NULL));
-
-    GLDebug::enable();
+    // The seed is recorded so the session can be replayed exactly
+    Replay recording;
+    recording.seed = config.seed;
+    recording.diamondCount = diamond_count;
 
 	// SHADERS
-	ShaderProgram shader("shaders/test.vert", "shaders/test.frag");
+	ShaderProgram shader("shaders/sprite.vert", "shaders/test.frag");
 
 	// CALLBACKS
-    auto callback_controller = std::make_shared<MyCallbacks>(shader, screen_width, screen_height);
+    InputQueue input(1024);
+    auto callback_controller = std::make_shared<MyCallbacks>(shader, input, screen_width, screen_height);
 	window.setCallbacks(callback_controller); // can also update callbacks to new ones
 
 	// GL_NEAREST looks a bit better for low-res pixel art than GL_LINEAR.
 	// But for most other cases, you'd want GL_LINEAR interpolation.
-	GameObject ship("textures/ship.png", GL_NEAREST);
-    GameObject diamond_1("textures/diamond.png", GL_NEAREST);
-    GameObject diamond_2("textures/diamond.png", GL_NEAREST);
-    GameObject diamond_3("textures/diamond.png", GL_NEAREST);
-    GameObject diamond_4("textures/diamond.png", GL_NEAREST);
-
-    ship.cgeom = objectGeom();
-    diamond_1.cgeom = objectGeom();
-    diamond_2.cgeom = objectGeom();
-    diamond_3.cgeom = objectGeom();
-    diamond_4.cgeom = objectGeom();
-
-    ship.ggeom.setVerts(ship.cgeom.verts);
-    ship.ggeom.setTexCoords(ship.cgeom.texCoords);
-
-    diamond_1.ggeom.setVerts(diamond_1.cgeom.verts);
-    diamond_1.ggeom.setTexCoords(diamond_1.cgeom.texCoords);
-
-    diamond_2.ggeom.setVerts(diamond_2.cgeom.verts);
-    diamond_2.ggeom.setTexCoords(diamond_2.cgeom.texCoords);
+    // Entities only store which kind they are; the texture they are drawn
+    // with is shared by every entity of a kind, and the render queue draws
+    // every kind with one instanced draw.
+	Texture ship_texture("textures/ship.png", GL_NEAREST);
+	Texture diamond_texture("textures/diamond.png", GL_NEAREST);
+    RenderQueue render_queue;
+    if (config.cull && window.hasComputeShaders()) render_queue.enableCulling();
+
+    // Diamonds first so the ship is drawn on top of them, with the fire in
+    // between
+    const uint8_t DIAMOND_LAYER = 0;
+    const uint8_t PARTICLE_LAYER = 1;
+    const uint8_t SHIP_LAYER = 2;
+
+    // Exhaust and explosions only exist on the GPU; the simulation never sees them
+    Texture fire_texture("textures/fire.png", GL_LINEAR);
+    ParticleSystem particles(static_cast<size_t>(config.particles), config.seed);
+    const float EXHAUST_PER_SECOND = 3000.0f;
+    const uint32_t EXPLOSION_PARTICLES = 1500;
+    float exhaust_carry = 0.0f;
+    uint64_t last_burst_tick = 0;
+
+    // --threads 1 runs every job inline on the simulation thread
+    JobSystem jobs(config.threads);
+
+    // Either the simulation runs on the CPU and ticks on its own thread, and
+    // the render loop only reads the snapshots it publishes, or it runs on
+    // the GPU and the render loop ticks it and draws straight from its
+    // buffers
+    std::unique_ptr<Simulation> simulation;
+    std::unique_ptr<SimulationThread> simulation_thread;
+    std::unique_ptr<GpuSimulation> gpu_simulation;
+    if (config.gpu_sim && !window.hasComputeShaders())
+    {
+        Log::warn("GPU_SIMULATION needs OpenGL 4.3, simulating on the CPU instead");
+    }
+    if (config.gpu_sim && window.hasComputeShaders())
+    {
+        gpu_simulation = std::make_unique<GpuSimulation>(diamond_count, config.seed);
+    }
+    else
+    {
+        // Default Locations setting
+        simulation = std::make_unique<Simulation>(jobs, diamond_count, config.seed);
+        simulation_thread = std::make_unique<SimulationThread>(*simulation, input);
+        simulation_thread->record(&recording);
+        simulation_thread->start();
+    }
 
-    diamond_3.ggeom.setVerts(diamond_3.cgeom.verts);
-    diamond_3.ggeom.setTexCoords(diamond_3.cgeom.texCoords);
+    // The GPU simulation ticks at the same rate as the simulation thread.
+    // Only the score comes back from it, so that is all its snapshots have.
+    const float GPU_TICKS_PER_SECOND = 60.0f;
+    float gpu_tick_carry = 0.0f;
+    RenderSnapshot gpu_snapshot;
 
-    diamond_4.ggeom.setVerts(diamond_4.cgeom.verts);
-    diamond_4.ggeom.setTexCoords(diamond_4.cgeom.texCoords);
+    std::vector<double> frame_ms;
+    frame_ms.reserve(config.bench_frames);
+    auto last_frame_start = std::chrono::steady_clock::now();
 
-    // Default Locations setting 
+    // RENDER LOOP
+	while (!window.shouldClose()) {
+        auto frame_start = std::chrono::steady_clock::now();
+        float frame_dt = std::min(std::chrono::duration<float>(frame_start - last_frame_start).count(), 0.1f);
+        last_frame_start = frame_start;
+        RenderStats::get().reset();
+
+		{
+			ProfileScope scope("poll_events");
+			glfwPollEvents();
+		}
 
-    diamond_1.v1 = -0.7 + (makeRandom() / 6);
-    diamond_1.v2 = 0.7 - (makeRandom() / 6);
-    diamond_1.theta = 0.0f;
-    diamond_1.scaling_factor = 0.125f;
+        if (gpu_simulation)
+        {
+            ProfileScope scope("gpu_simulation");
+            InputEvent event;
+            while (input.tryPop(event)) gpu_simulation->handleInput(event);
 
-    diamond_2.v1 = 0.7 - (makeRandom() / 6);
-    diamond_2.v2 = 0.7 - (makeRandom() / 6);
-    diamond_2.theta = 0.0f;
-    diamond_2.scaling_factor = 0.125f;
+            gpu_tick_carry += GPU_TICKS_PER_SECOND * frame_dt;
+            for (; gpu_tick_carry >= 1.0f; gpu_tick_carry -= 1.0f) gpu_simulation->update();
 
-    diamond_3.v1 = -0.7 + (makeRandom() / 6);
-    diamond_3.v2 = -0.7 + (makeRandom() / 6);
-    diamond_3.theta = 0.0f;
-    diamond_3.scaling_factor = 0.125f;
+            gpu_snapshot.tick = gpu_simulation->getTick();
+            gpu_snapshot.score = gpu_simulation->getScore();
+            gpu_snapshot.won = gpu_simulation->hasWon();
+        }
 
-    diamond_4.v1 = 0.7 - (makeRandom() / 6);
-    diamond_4.v2 = -0.7 + (makeRandom() / 6);
-    diamond_4.theta = 0.0f;
-    diamond_4.scaling_factor = 0.125f;
+        // Stays unchanged until the next call to latest()
+        const RenderSnapshot& snapshot = simulation_thread ? simulation_thread->latest() : gpu_snapshot;
 
-    ship.v1 = keepWithin(0.5);
-    ship.v2 = keepWithin(0.5);
+        // Exhaust comes out at a steady rate while the ship moves, whatever
+        // the frame rate. Every diamond collected since the last snapshot we
+        // saw gets one explosion; bursts stay in the snapshots for a few
+        // ticks so skipped snapshots don't lose any.
+        {
+            ProfileScope scope("particles");
+            if (snapshot.thrusting)
+            {
+                exhaust_carry += EXHAUST_PER_SECOND * frame_dt;
+                uint32_t count = static_cast<uint32_t>(exhaust_carry);
+                exhaust_carry -= static_cast<float>(count);
+                particles.emit(makeExhaust(snapshot.exhaustPosition, snapshot.exhaustDirection, count));
+            }
+            for (const ParticleBurst& burst : snapshot.bursts)
+            {
+                if (burst.tick > last_burst_tick) particles.emit(makeExplosion(burst.position, EXPLOSION_PARTICLES));
+            }
+            last_burst_tick = std::max(last_burst_tick, snapshot.tick);
+            particles.update(frame_dt);
+        }
 
-    ship.target_v1 = ship.v1;
-    ship.target_v2 = ship.v2;
-    ship.theta = 0.0f;
-    ship.target_theta = 0.0f;
-    ship.direction = makeUnitVector(glm::vec3(ship.v1 - ship.v1, 1.0f - ship.v2, 0.0f));
-    ship.scaling_factor = 0.125f;
-    int score_value = 0;
+		{
+			ProfileScope scope("draw");
 
-    State state = callback_controller->getState();
+            if (gpu_simulation)
+            {
+                render_queue.submitSpriteBuffer(DIAMOND_LAYER, shader, diamond_texture, gpu_simulation->getDiamondInstances(), gpu_simulation->getDiamondCount());
+                render_queue.submitSpriteBuffer(SHIP_LAYER, shader, ship_texture, gpu_simulation->getShipInstance(), 1);
+            }
+            else
+            {
+                render_queue.submitSprites(DIAMOND_LAYER, shader, diamond_texture, snapshot.diamonds);
+                render_queue.submitSprites(SHIP_LAYER, shader, ship_texture, snapshot.ships);
+            }
+            render_queue.submitCustom(PARTICLE_LAYER, [&]() { particles.draw(fire_texture); });
 
-    // RENDER LOOP
-	while (!window.shouldClose()) {
-		glfwPollEvents();
+            GLState::get().enable(GL_FRAMEBUFFER_SRGB);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        state = callback_controller->getState();
+            render_queue.flush();
 
-        if (state.reset == true)
-        {
-            // Default Locations setting
-
-            diamond_1.v1 = -0.7 + (makeRandom() / 6);
-            diamond_1.v2 = 0.7 - (makeRandom() / 6);
-            diamond_1.theta = 0.0f;
-            diamond_1.scaling_factor = 0.125f;
-
-            diamond_2.v1 = 0.7 - (makeRandom() / 6);
-            diamond_2.v2 = 0.7 - (makeRandom() / 6);
-            diamond_2.theta = 0.0f;
-            diamond_2.scaling_factor = 0.125f;
-
-            diamond_3.v1 = -0.7 + (makeRandom() / 6);
-            diamond_3.v2 = -0.7 + (makeRandom() / 6);
-            diamond_3.theta = 0.0f;
-            diamond_3.scaling_factor = 0.125f;
-
-            diamond_4.v1 = 0.7 - (makeRandom() / 6);
-            diamond_4.v2 = -0.7 + (makeRandom() / 6);
-            diamond_4.theta = 0.0f;
-            diamond_4.scaling_factor = 0.125f;
-
-            ship.v1 = keepWithin(0.5);
-            ship.v2 = keepWithin(0.5);
-
-            ship.target_v1 = ship.v1;
-            ship.target_v2 = ship.v2;
-            ship.theta = 0.0f;
-            ship.target_theta = 0.0f;
-            ship.direction = makeUnitVector(glm::vec3(ship.v1 - ship.v1, 1.0f - ship.v2, 0.0f));
-            ship.scaling_factor = 0.125f;
-            score_value = 0;
-
-            state.stateReset();
-        }
+            GLState::get().disable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
+		}
 
-        if (state.stateChanged())
-        {
-            if(state.mouse_clicked)
+		{
+			ProfileScope scope("imgui");
+			// Starting the new ImGui frame
+			ImGui_ImplOpenGL3_NewFrame();
+			ImGui_ImplGlfw_NewFrame();
+			ImGui::NewFrame();
+			// Putting the text-containing window in the top-left of the screen.
+			ImGui::SetNextWindowPos(ImVec2(5, 5));
+
+			// Setting flags
+			ImGuiWindowFlags textWindowFlags =
+				ImGuiWindowFlags_NoMove |				// text "window" should not move
+				ImGuiWindowFlags_NoResize |				// should not resize
+				ImGuiWindowFlags_NoCollapse |			// should not collapse
+				ImGuiWindowFlags_NoSavedSettings |		// don't want saved settings mucking things up
+				ImGuiWindowFlags_AlwaysAutoResize |		// window should auto-resize to fit the text
+				ImGuiWindowFlags_NoBackground |			// window should be transparent; only the text should be visible
+				ImGuiWindowFlags_NoDecoration |			// no decoration; only the text should be visible
+				ImGuiWindowFlags_NoTitleBar;			// no title; only the text should be visible
+
+			// Begin a new window with these flags. (bool *)0 is the "default" value for its argument.
+			ImGui::Begin("scoreText", (bool *)0, textWindowFlags);
+
+			// Scale up text a little, and set its value
+			ImGui::SetWindowFontScale(1.5f);
+            if (!snapshot.won)
             {
-                ship.target_theta = findRotationTheta(state, ship);
+                ImGui::Text("Score: %d", snapshot.score); // Second parameter gets passed into "%d"
             }
-
-            if(state.up_pressed)
+			else 
             {
-                std::tuple new_positions = moveShip(ship);
-                ship.target_v1 += std::get<0>(new_positions);
-                ship.target_v2 += std::get<1>(new_positions);
+                ImGui::Text("Congratulations !! You've won the game"); // Second parameter gets passed into "%d"
             }
 
-            if(state.down_pressed)
+			// End the window.
+			ImGui::End();
+
+            // Everything the frame drew is counted by now; ImGui itself isn't
+            if (config.stats)
             {
-                std::tuple new_positions = moveShip(ship);
-                ship.target_v1 -= std::get<0>(new_positions);
-                ship.target_v2 -= std::get<1>(new_positions);
+                const RenderStats& stats = RenderStats::get();
+                ImGui::SetNextWindowPos(ImVec2(static_cast<float>(screen_width) - 5.0f, 5.0f), 0, ImVec2(1.0f, 0.0f));
+                ImGui::SetNextWindowBgAlpha(0.5f);
+                ImGui::Begin("stats", (bool *)0, textWindowFlags & ~ImGuiWindowFlags_NoBackground);
+                ImGui::Text("Frame: %.2f ms (median %.2f ms)", FlightRecorder::get().getLastFrameMs(), FlightRecorder::get().getMedianFrameMs());
+                ImGui::Text("Draw calls: %llu", static_cast<unsigned long long>(stats.drawCalls));
+                ImGui::Text("Instances: %llu", static_cast<unsigned long long>(stats.instances));
+                ImGui::Text("State changes: %llu (%llu skipped)", static_cast<unsigned long long>(stats.stateChanges), static_cast<unsigned long long>(stats.redundantStateChanges));
+                ImGui::Text("Uniform updates: %llu", static_cast<unsigned long long>(stats.uniformUpdates));
+                ImGui::Text("Uploaded: %.1f KiB", stats.bytesUploaded / 1024.0);
+                ImGui::End();
             }
 
-            callback_controller->stateHandled();
-        }
+			ImGui::Render();	// Render the ImGui window
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Some middleware thing
 
-		shader.use();
-
-        glEnable(GL_FRAMEBUFFER_SRGB);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        diamond_1.ggeom.bind();
-
-        GLint location_1 = glGetUniformLocation(shader.getID(), "scaling_factor");
-        glUniform1f(location_1, diamond_1.scaling_factor);
-        GLint location_2 = glGetUniformLocation(shader.getID(), "theta");
-        glUniform1f(location_2, diamond_1.theta);
-        GLint location_3 = glGetUniformLocation(shader.getID(), "v1");
-        glUniform1f(location_3, diamond_1.v1);
-        GLint location_4 = glGetUniformLocation(shader.getID(), "v2");
-        glUniform1f(location_4, diamond_1.v2);
-
-        diamond_1.texture.bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        diamond_1.texture.unbind();
-
-        diamond_2.ggeom.bind();
-
-        location_1 = glGetUniformLocation(shader.getID(), "scaling_factor");
-        glUniform1f(location_1, diamond_2.scaling_factor);
-        location_2 = glGetUniformLocation(shader.getID(), "theta");
-        glUniform1f(location_2, diamond_2.theta);
-        location_3 = glGetUniformLocation(shader.getID(), "v1");
-        glUniform1f(location_3, diamond_2.v1);
-        location_4 = glGetUniformLocation(shader.getID(), "v2");
-        glUniform1f(location_4, diamond_2.v2);
-
-        diamond_2.texture.bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        diamond_2.texture.unbind();
-
-        diamond_3.ggeom.bind();
-
-        location_1 = glGetUniformLocation(shader.getID(), "scaling_factor");
-        glUniform1f(location_1, diamond_3.scaling_factor);
-        location_2 = glGetUniformLocation(shader.getID(), "theta");
-        glUniform1f(location_2, diamond_3.theta);
-        location_3 = glGetUniformLocation(shader.getID(), "v1");
-        glUniform1f(location_3, diamond_3.v1);
-        location_4 = glGetUniformLocation(shader.getID(), "v2");
-        glUniform1f(location_4, diamond_3.v2);
-
-        diamond_3.texture.bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        diamond_3.texture.unbind();
-
-        diamond_4.ggeom.bind();
-
-        location_1 = glGetUniformLocation(shader.getID(), "scaling_factor");
-        glUniform1f(location_1, diamond_4.scaling_factor);
-        location_2 = glGetUniformLocation(shader.getID(), "theta");
-        glUniform1f(location_2, diamond_4.theta);
-        location_3 = glGetUniformLocation(shader.getID(), "v1");
-        glUniform1f(location_3, diamond_4.v1);
-        location_4 = glGetUniformLocation(shader.getID(), "v2");
-        glUniform1f(location_4, diamond_4.v2);
-
-        diamond_4.texture.bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        diamond_4.texture.unbind();
-
-        ship.ggeom.bind();
-
-        location_1 = glGetUniformLocation(shader.getID(), "scaling_factor");
-        glUniform1f(location_1, ship.scaling_factor);
-        location_2 = glGetUniformLocation(shader.getID(), "theta");
-        if (notCloseEnoughAngle(ship.theta, ship.target_theta))
-        {
-            if (ship.theta < ship.target_theta) ship.theta += 0.05f;
-            if (ship.theta > ship.target_theta) ship.theta -= 0.05f;
-        } 
-        else ship.theta = ship.target_theta;
-        glUniform1f(location_2, ship.theta);
-        location_3 = glGetUniformLocation(shader.getID(), "v1");
-        if (notCloseEnoughPosition(ship.v1, ship.target_v1))
-        {
-            if (ship.v1 < ship.target_v1) ship.v1 += (abs(ship.v1 - ship.target_v1) * 1.0005f);
-            if (ship.v1 > ship.target_v1) ship.v1 -= (abs(ship.v1 - ship.target_v1) * 1.0005f);
-        }
-        else ship.v1 = ship.target_v1;
-        glUniform1f(location_3, ship.v1);
-        location_4 = glGetUniformLocation(shader.getID(), "v2");
-        if (notCloseEnoughPosition(ship.v2, ship.target_v2))
-        {
-            if (ship.v2 < ship.target_v2) ship.v2 += (abs(ship.v2 - ship.target_v2) * 1.0005f);
-            if (ship.v2 > ship.target_v2) ship.v2 -= (abs(ship.v2 - ship.target_v2) * 1.0005f);
-        }
-        else ship.v2 = ship.target_v2;
-        glUniform1f(location_4, ship.v2);
+            // ImGui sets GL state without going through the cache
+            GLState::get().invalidate();
+		}
 
-        ship.texture.bind();
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        ship.texture.unbind();
+		{
+			ProfileScope scope("swap");
+			window.swapBuffers();
+		}
 
-        glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
+        // Delete GL objects released in earlier frames the GPU is done with
+        GLObjectPool::get().collect();
 
-        if (withinOrbit(ship, diamond_1))
-        {
-            score_value += 1;
-            diamond_1.v1 = -5.0f;
-            ship.scaling_factor *= 1.05;
-        } 
+		FlightRecorder::get().endFrame();
 
-        if (withinOrbit(ship, diamond_2))
+        if (config.bench_frames > 0)
         {
-            score_value += 1;
-            diamond_2.v1 = -5.0f;
-            ship.scaling_factor *= 1.05;
+            frame_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+            if (static_cast<int>(frame_ms.size()) >= config.bench_frames) break;
         }
+	}
+    if (simulation_thread) simulation_thread->stop();
+    logTimings("frames", frame_ms);
 
-        if (withinOrbit(ship, diamond_3))
-        {
-            score_value += 1;
-            diamond_3.v1 = -5.0f;
-            ship.scaling_factor *= 1.05;
-        }
+    // The GPU simulation can't be replayed, so there is nothing to save
+    try
+    {
+        if (simulation_thread) recording.save(config.record);
+    }
+    catch (std::runtime_error &e)
+    {
+        Log::warn("REPLAY session was not saved: {}", e.what());
+    }
 
-        if (withinOrbit(ship, diamond_4))
-        {
-            score_value += 1;
-            diamond_4.v1 = -5.0f;
-            ship.scaling_factor *= 1.05;
-        }
+    return 0;
+}
 
-		// Starting the new ImGui frame
-		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
-		ImGui::NewFrame();
-		// Putting the text-containing window in the top-left of the screen.
-		ImGui::SetNextWindowPos(ImVec2(5, 5));
-
-		// Setting flags
-		ImGuiWindowFlags textWindowFlags =
-			ImGuiWindowFlags_NoMove |				// text "window" should not move
-			ImGuiWindowFlags_NoResize |				// should not resize
-			ImGuiWindowFlags_NoCollapse |			// should not collapse
-			ImGuiWindowFlags_NoSavedSettings |		// don't want saved settings mucking things up
-			ImGuiWindowFlags_AlwaysAutoResize |		// window should auto-resize to fit the text
-			ImGuiWindowFlags_NoBackground |			// window should be transparent; only the text should be visible
-			ImGuiWindowFlags_NoDecoration |			// no decoration; only the text should be visible
-			ImGuiWindowFlags_NoTitleBar;			// no title; only the text should be visible
-
-		// Begin a new window with these flags. (bool *)0 is the "default" value for its argument.
-		ImGui::Begin("scoreText", (bool *)0, textWindowFlags);
-
-		// Scale up text a little, and set its value
-		ImGui::SetWindowFontScale(1.5f);
-        if (score_value < 4)
-        {
-            ImGui::Text("Score: %d", score_value); // Second parameter gets passed into "%d"
-        }
-		else 
-        {
-            ImGui::Text("Congratulations !! You've won the game"); // Second parameter gets passed into "%d"
-        }
+int main(int argc, char* argv[]) {
+	Log::debug("Starting main");
 
-		// End the window.
-		ImGui::End();
+    if (argh::parser(argc, argv)[{ "h", "help" }])
+    {
+        std::cout << USAGE;
+        return 0;
+    }
 
-		ImGui::Render();	// Render the ImGui window
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Some middleware thing
+    Config config = parseConfig(argc, argv);
+    if (!config.replay.empty()) return runReplay(config);
+    if (config.headless) return runHeadless(config);
+
+	// WINDOW
+	glfwInit();
+	Window window(config.width, config.height, "CPSC 453 Assignment 2"); // can set callbacks at construction if desired
+    glfwSwapInterval(config.vsync ? 1 : 0);
+
+    GLDebug::enable();
+    GLState::get().allowDirectStateAccess(config.dsa);
+
+    int result = runGame(window, config);
 
-		window.swapBuffers();
-	}
 	// ImGui cleanup
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
 
 	glfwTerminate();
-	return 0;
+	return result;
 }
@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 color;
+
+in vec2 tc;
+in float fade;
+
+uniform sampler2D sampler;
+
+// Drawn with additive blending, so overlapping particles get brighter
+void main() {
+	vec4 d = texture(sampler, tc);
+	color = vec4(d.rgb, d.a * fade);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec4 corner;   // quad corner xy, texture coordinate uv
+layout (location = 1) in vec4 motion;   // per particle: position.xy, velocity.xy
+layout (location = 2) in vec2 ageLife;  // per particle: seconds alive, seconds it lives for
+
+out vec2 tc;
+out float fade;
+
+uniform float size;
+
+void main() {
+	tc = corner.zw;
+
+	// Dead particles are moved outside the clip volume, so they are clipped
+	// before any fragment work
+	if (ageLife.x >= ageLife.y) {
+		fade = 0.0;
+		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+		return;
+	}
+
+	// Fade out and shrink to half size over the particle's life
+	fade = 1.0 - ageLife.x / ageLife.y;
+	gl_Position = vec4(motion.xy + corner.xy * size * (0.5 + 0.5 * fade), 0.0, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// The update pass runs with GL_RASTERIZER_DISCARD, so this never runs; it
+// is only here because ShaderProgram links a vertex and a fragment shader.
+void main() {
+}
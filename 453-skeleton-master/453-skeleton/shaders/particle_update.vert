@@ -0,0 +1,68 @@
+#version 330 core
+layout (location = 0) in vec4 motion;   // position.xy, velocity.xy
+layout (location = 1) in vec2 ageLife;  // seconds alive, seconds it lives for
+
+// Captured with transform feedback into the other particle buffer
+out vec4 outMotion;
+out vec2 outAgeLife;
+
+// Keep in sync with MAX_EMITTERS in ParticleSystem.cpp
+const int MAX_EMITTERS = 16;
+
+uniform float dt;
+uniform float drag;
+uniform uint seed;
+uniform int capacity;
+
+uniform int emitterCount;
+uniform vec4 emitterOrigin[MAX_EMITTERS];  // position.xy, direction.xy
+uniform vec4 emitterShape[MAX_EMITTERS];   // speed, speed jitter, spread (radians), lifetime
+uniform ivec2 emitterSlots[MAX_EMITTERS];  // first slot, count (wrapping at capacity)
+
+// Integer hash (https://nullprogram.com/blog/2018/07/31/), so every slot
+// gets its own random numbers each frame
+uint hash(uint x) {
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+float random(uint k) {
+	uint h = hash(uint(gl_VertexID) * 4u + k + hash(seed));
+	return float(h >> 8) * (1.0 / 16777216.0);
+}
+
+void main() {
+	// Slots handed to an emitter this frame start a new particle...
+	for (int e = 0; e < emitterCount; e++) {
+		int offset = gl_VertexID - emitterSlots[e].x;
+		if (offset < 0) offset += capacity;
+		if (offset < emitterSlots[e].y) {
+			vec4 origin = emitterOrigin[e];
+			vec4 shape = emitterShape[e];
+
+			float angle = (random(0u) - 0.5) * shape.z;
+			float c = cos(angle);
+			float s = sin(angle);
+			vec2 direction = vec2(c * origin.z - s * origin.w, s * origin.z + c * origin.w);
+			float speed = shape.x * (1.0 + shape.y * (2.0 * random(1u) - 1.0));
+
+			outMotion = vec4(origin.xy, direction * speed);
+			outAgeLife = vec2(0.0, shape.w * (0.5 + 0.5 * random(2u)));
+			return;
+		}
+	}
+
+	// ...everything else moves, slows down and ages
+	vec2 position = motion.xy;
+	vec2 velocity = motion.zw;
+	if (ageLife.x < ageLife.y) {
+		velocity *= max(1.0 - drag * dt, 0.0);
+		position += velocity * dt;
+	}
+	outMotion = vec4(position, velocity);
+	outAgeLife = vec2(ageLife.x + dt, ageLife.y);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 texCoord;
+layout (location = 2) in vec4 instance; // v1, v2, scaling_factor * (cos(theta), sin(theta))
+
+out vec2 tc;
+
+// Same scaling, rotation and translation as test.vert, but the parameters
+// come from a per-instance attribute instead of uniforms. The CPU already
+// folded the scale into cos and sin, so there is no trig per vertex.
+void main() {
+	tc = texCoord;
+
+	float c = instance.z;
+	float s = instance.w;
+	vec2 rotated = vec2(c * pos.x + s * pos.y, -s * pos.x + c * pos.y);
+
+	gl_Position = vec4(rotated + instance.xy * pos.z, pos.z, 1.0);
+}
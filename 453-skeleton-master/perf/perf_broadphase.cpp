@@ -0,0 +1,159 @@
+#include "GameMath.h"
+#include "InputEvent.h"
+#include "JobSystem.h"
+#include "Simulation.h"
+#include "SpatialHash.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Many ships against many diamonds spread over a world that grows with the
+// number of diamonds, so the number of diamonds near each ship stays about
+// the same. Brute force grows with ships * diamonds, the grid should grow
+// roughly with ships + diamonds.
+
+static void make_points(std::size_t Count, float Extent, unsigned int Seed, std::vector<float>& X, std::vector<float>& Y)
+{
+	std::mt19937 Rng(Seed);
+	std::uniform_real_distribution<float> Coord(-Extent, Extent);
+	X.resize(Count);
+	Y.resize(Count);
+	for(std::size_t i = 0; i < Count; ++i)
+	{
+		X[i] = Coord(Rng);
+		Y[i] = Coord(Rng);
+	}
+}
+
+static int launch_brute_force(std::vector<float> const& SX, std::vector<float> const& SY, std::vector<float> const& DX, std::vector<float> const& DY, std::size_t& Hits)
+{
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	Hits = 0;
+	for(std::size_t s = 0; s < SX.size(); ++s)
+		for(std::size_t d = 0; d < DX.size(); ++d)
+			Hits += withinOrbit(glm::vec2(SX[s], SY[s]), glm::vec2(DX[d], DY[d])) ? 1 : 0;
+
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+}
+
+static int launch_spatial_hash(std::vector<float> const& SX, std::vector<float> const& SY, std::vector<float> const& DX, std::vector<float> const& DY, std::size_t& Hits)
+{
+	SpatialHash Grid(ORBIT_RADIUS);
+	std::vector<uint32_t> Nearby;
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	// Rebuilt every time, as the simulation does every tick
+	Grid.build(DX.data(), DY.data(), DX.size());
+	Hits = 0;
+	for(std::size_t s = 0; s < SX.size(); ++s)
+	{
+		Nearby.clear();
+		Grid.queryRadius(glm::vec2(SX[s], SY[s]), ORBIT_RADIUS, DX.data(), DY.data(), Nearby);
+		Hits += Nearby.size();
+	}
+
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+}
+
+static int comp_broadphase(std::size_t Ships, std::size_t Diamonds)
+{
+	// About 16 diamonds per unit of area
+	float const Extent = std::max(1.0f, std::sqrt(static_cast<float>(Diamonds) / 64.0f));
+
+	std::vector<float> SX, SY, DX, DY;
+	make_points(Ships, Extent, 1, SX, SY);
+	make_points(Diamonds, Extent, 2, DX, DY);
+
+	std::printf("%6zu ships x %7zu diamonds:\n", Ships, Diamonds);
+
+	std::size_t GridHits = 0;
+	std::printf("- spatial hash: %8d us\n", launch_spatial_hash(SX, SY, DX, DY, GridHits));
+
+	// Brute force gets too slow to be worth waiting for
+	if(Ships * Diamonds > 2000000000ull)
+		return 0;
+
+	std::size_t BruteHits = 0;
+	std::printf("- brute force:  %8d us\n", launch_brute_force(SX, SY, DX, DY, BruteHits));
+
+	return GridHits == BruteHits ? 0 : 1;
+}
+
+// The same game played with the sweep and with the grid must hand every
+// diamond to the same ship (the lowest indexed one in reach), so the owners,
+// score and state hash have to agree after every tick. Ships spawn in the
+// middle of the screen and diamonds around its corners, so it takes dozens
+// of ships before diamonds are in reach of several at once.
+static int comp_simulation(int Ships, int Diamonds, int Ticks)
+{
+	JobSystem Jobs(1);
+	Simulation Sweep(Jobs, Diamonds, 1234, Ships);
+	Simulation Grid(Jobs, Diamonds, 1234, Ships);
+	Sweep.setBroadphase(Broadphase::Sweep);
+	Grid.setBroadphase(Broadphase::Grid);
+
+	std::mt19937 Rng(3);
+	std::uniform_real_distribution<float> Coord(-1.0f, 1.0f);
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	int Error = 0;
+	for(int Tick = 0; Tick < Ticks; ++Tick)
+	{
+		// Fly the player's ship around so it keeps reaching new diamonds
+		InputEvent Event;
+		Event.type = InputEventType::TurnToward;
+		Event.position = glm::vec2(Coord(Rng), Coord(Rng));
+		if(Tick % 10 == 0)
+		{
+			Sweep.handleInput(Event);
+			Grid.handleInput(Event);
+		}
+		Event.type = Tick % 40 < 30 ? InputEventType::ForwardPressed : InputEventType::ForwardReleased;
+		Sweep.handleInput(Event);
+		Grid.handleInput(Event);
+
+		Sweep.update();
+		Grid.update();
+		// Ship growth caps quickly, so compare who collected each diamond
+		// directly rather than trusting the state to show it
+		if(Sweep.stateHash() != Grid.stateHash() || Sweep.getScore() != Grid.getScore()
+			|| Sweep.getCollectedOwners() != Grid.getCollectedOwners())
+			++Error;
+	}
+
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	std::printf("%6d ships x %7d diamonds, %d ticks: score %d, %d mismatched ticks, %8d us\n",
+		Ships, Diamonds, Ticks, Sweep.getScore(), Error,
+		static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count()));
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	Error += comp_broadphase(1, 4);
+	Error += comp_broadphase(1, 10000);
+	Error += comp_broadphase(100, 10000);
+	Error += comp_broadphase(1000, 10000);
+	Error += comp_broadphase(1000, 100000);
+	Error += comp_broadphase(10000, 100000);
+	Error += comp_broadphase(10000, 1000000);
+
+	Error += comp_simulation(64, 20000, 200);
+	Error += comp_simulation(256, 100000, 100);
+
+	return Error;
+}
@@ -0,0 +1,91 @@
+#include "CullKernel.h"
+#include "OrbitKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Culling reads 12 bytes per circle (x, y and radius) and writes 4 for each
+// visible one. Each variant is reported in millions of circles per second,
+// on a scene where about half of them are on screen, and must produce the
+// same visible list as the scalar version.
+
+typedef std::size_t (*cull_circles)(ViewRect const&, float const*, float const*, float const*, float, std::size_t, uint32_t*);
+
+static double launch_cull(cull_circles Function, std::vector<float> const& X, std::vector<float> const& Y, std::vector<float> const& Radius, std::vector<uint32_t>& Visible, std::size_t Repeats, std::size_t& Count)
+{
+	ViewRect const View = {glm::vec2(-1.0f), glm::vec2(1.0f)};
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	for(std::size_t r = 0; r < Repeats; ++r)
+		Count = Function(View, X.data(), Y.data(), Radius.data(), 1.41421356f, X.size(), Visible.data());
+
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(t2 - t1).count();
+}
+
+static int comp_cull_kernel(char const* Label, std::size_t Circles, std::size_t Repeats)
+{
+	std::mt19937 Rng(1);
+	std::uniform_real_distribution<float> Coord(-1.4f, 1.4f);
+
+	// Every tenth one is still popping in (radius 0) and never visible
+	std::vector<float> X(Circles), Y(Circles), Radius(Circles);
+	for(std::size_t i = 0; i < Circles; ++i)
+	{
+		X[i] = Coord(Rng);
+		Y[i] = Coord(Rng);
+		Radius[i] = i % 10 == 0 ? 0.0f : 0.125f;
+	}
+
+	std::printf("%s: %zu circles\n", Label, Circles);
+
+	cull_circles const Functions[] = {cullCirclesScalar, cullCirclesSSE2, cullCirclesAVX2};
+	SimdLevel const Levels[] = {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2};
+	SimdLevel const Supported = detectSimdLevel();
+
+	std::vector<uint32_t> Reference(Circles);
+	std::size_t ReferenceCount = 0;
+	launch_cull(cullCirclesScalar, X, Y, Radius, Reference, 1, ReferenceCount);
+	Reference.resize(ReferenceCount);
+
+	int Error = 0;
+	for(std::size_t f = 0; f < 3; ++f)
+	{
+		if(static_cast<int>(Levels[f]) > static_cast<int>(Supported))
+		{
+			std::printf("- %-11s  not supported\n", simdLevelName(Levels[f]));
+			continue;
+		}
+
+		std::vector<uint32_t> Visible(Circles);
+		std::size_t Count = 0;
+		double const Time = launch_cull(Functions[f], X, Y, Radius, Visible, Repeats, Count);
+		std::printf("- %-11s %8.1f M circles/s, %zu visible\n", simdLevelName(Levels[f]), static_cast<double>(Circles) * Repeats / Time / 1e6, Count);
+
+		Visible.resize(Count);
+		Error += (Count == ReferenceCount && Visible == Reference) ? 0 : 1;
+	}
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	std::printf("detected: %s\n", simdLevelName(detectSimdLevel()));
+
+	// Odd sizes also exercise the scalar tail
+	Error += comp_cull_kernel("tail only", 5, 100000);
+	Error += comp_cull_kernel("in L1", 2048 + 3, 100000);
+	Error += comp_cull_kernel("in L2", 16384, 10000);
+	Error += comp_cull_kernel("out of cache", 16 * 1024 * 1024 + 5, 10);
+
+	return Error;
+}
@@ -0,0 +1,271 @@
+#include "FastMath.h"
+#include "GameMath.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// std::sin/cos/atan2 against the polynomial versions, checking the error
+// bounds documented in FastMath.h, and the old angle based ship turning
+// against the unit complex rotations that replaced it.
+
+// Keeps results alive so the compiler can't optimize the measured work away
+static volatile float Sink = 0.0f;
+
+// Bounds from FastMath.h
+static float const SinCosBound = 1e-7f;
+static float const Atan2Bound = 2e-6f;
+
+// Runs f a few times and returns the fastest run in nanoseconds per operation
+template <typename F>
+static double launch_ns_per_op(std::size_t Samples, F&& f)
+{
+	double Best = 1e30;
+	for(int Run = 0; Run < 5; ++Run)
+	{
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		f();
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
+		Best = std::min(Best, ns / static_cast<double>(Samples));
+	}
+	return Best;
+}
+
+// What findRotationTheta() used to do, minus the comments
+static float legacy_find_rotation_theta(glm::vec2 target, glm::vec2 position, glm::vec3& direction, float target_theta)
+{
+	glm::vec3 new_direction = makeUnitVector(glm::vec3(target.x - position.x, target.y - position.y, 0.0f));
+	glm::vec3 standard = glm::vec3(0.0f, 1.0f, 0.0f);
+
+	if (new_direction == direction)
+		return target_theta;
+
+	double dot1 = direction.x * new_direction.x + direction.y * new_direction.y;
+	double theta1 = std::acos(dot1);
+	double dot2 = standard.x * direction.x + standard.y * direction.y;
+	double theta2 = std::acos(dot2);
+	double or_1 = direction.x * -new_direction.y + direction.y * new_direction.x;
+	double or_2 = standard.x * -direction.y + standard.y * direction.x;
+
+	double theta;
+	if (or_1 > 0)
+	{
+		if (standard.x > direction.x)
+			theta2 = 2 * M_PI - theta2;
+		theta = theta1 + theta2;
+	}
+	else if (or_2 < 0)
+		theta = 2 * M_PI - (theta2 + theta1);
+	else
+		theta = theta2 - theta1;
+
+	direction = new_direction;
+	return static_cast<float>(theta);
+}
+
+static int perf_sin_cos(std::size_t Samples, float Range)
+{
+	int Error = 0;
+
+	std::mt19937 Rng(453);
+	std::uniform_real_distribution<float> Angle(-Range, Range);
+	std::vector<float> X(Samples), S(Samples), C(Samples), BatchS(Samples), BatchC(Samples);
+	for(float& x : X)
+		x = Angle(Rng);
+
+	std::printf("std::sin + std::cos:  %8.2f ns/op (|x| <= %g)\n", launch_ns_per_op(Samples, [&]()
+	{
+		for(std::size_t i = 0; i < Samples; ++i)
+		{
+			S[i] = std::sin(X[i]);
+			C[i] = std::cos(X[i]);
+		}
+		Sink = S[Samples / 2];
+	}), Range);
+
+	std::printf("fastSinCos:           %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		for(std::size_t i = 0; i < Samples; ++i)
+			fastSinCos(X[i], S[i], C[i]);
+		Sink = S[Samples / 2];
+	}));
+
+	std::printf("fastSinCos (array):   %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		fastSinCos(X.data(), BatchS.data(), BatchC.data(), Samples);
+		Sink = BatchS[Samples / 2];
+	}));
+
+	double MaxError = 0.0;
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		MaxError = std::max(MaxError, std::abs(static_cast<double>(S[i]) - std::sin(static_cast<double>(X[i]))));
+		MaxError = std::max(MaxError, std::abs(static_cast<double>(C[i]) - std::cos(static_cast<double>(X[i]))));
+		Error += (S[i] == BatchS[i] && C[i] == BatchC[i]) ? 0 : 1;
+	}
+	std::printf("  max error %.3g\n", MaxError);
+	Error += MaxError <= SinCosBound ? 0 : 1;
+
+	return Error;
+}
+
+static int perf_atan2(std::size_t Samples)
+{
+	int Error = 0;
+
+	// Mixed magnitudes, so every octant and both steep and shallow angles
+	// come up, plus the axes and the origin
+	std::mt19937 Rng(453);
+	std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> Exponent(-10.0f, 10.0f);
+	std::vector<float> X(Samples), Y(Samples), Out(Samples), BatchOut(Samples);
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		X[i] = Unit(Rng) * std::exp2(Exponent(Rng));
+		Y[i] = Unit(Rng) * std::exp2(Exponent(Rng));
+	}
+	float const Special[] = { 0.0f, -0.0f, 1.0f, -1.0f };
+	for(std::size_t i = 0; i < 16; ++i)
+	{
+		X[i] = Special[i % 4];
+		Y[i] = Special[i / 4];
+	}
+
+	std::printf("std::atan2:           %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		for(std::size_t i = 0; i < Samples; ++i)
+			Out[i] = std::atan2(Y[i], X[i]);
+		Sink = Out[Samples / 2];
+	}));
+
+	std::printf("fastAtan2:            %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		for(std::size_t i = 0; i < Samples; ++i)
+			Out[i] = fastAtan2(Y[i], X[i]);
+		Sink = Out[Samples / 2];
+	}));
+
+	std::printf("fastAtan2 (array):    %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		fastAtan2(Y.data(), X.data(), BatchOut.data(), Samples);
+		Sink = BatchOut[Samples / 2];
+	}));
+
+	double MaxError = 0.0;
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		double Reference = (X[i] == 0.0f && Y[i] == 0.0f) ? 0.0 : std::atan2(static_cast<double>(Y[i]), static_cast<double>(X[i]));
+		MaxError = std::max(MaxError, std::abs(static_cast<double>(Out[i]) - Reference));
+		Error += Out[i] == BatchOut[i] ? 0 : 1;
+	}
+	std::printf("  max error %.3g\n", MaxError);
+	Error += MaxError <= Atan2Bound ? 0 : 1;
+
+	return Error;
+}
+
+static int perf_rotation(std::size_t Samples)
+{
+	int Error = 0;
+
+	std::mt19937 Rng(453);
+	std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+	std::vector<float> X(Samples), Y(Samples);
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		X[i] = Unit(Rng);
+		Y[i] = Unit(Rng);
+	}
+
+	// Every click somewhere random on screen
+	std::printf("findRotationTheta:    %8.2f ns/op (old, random targets)\n", launch_ns_per_op(Samples, [&]()
+	{
+		glm::vec3 Direction(0.0f, 1.0f, 0.0f);
+		float Theta = 0.0f;
+		for(std::size_t i = 0; i < Samples; ++i)
+			Theta = legacy_find_rotation_theta(glm::vec2(X[i], Y[i]), glm::vec2(0.0f), Direction, Theta);
+		Sink = Theta;
+	}));
+
+	std::printf("directionToward:      %8.2f ns/op (random targets)\n", launch_ns_per_op(Samples, [&]()
+	{
+		glm::vec2 Direction(0.0f, 1.0f);
+		for(std::size_t i = 0; i < Samples; ++i)
+			Direction = directionToward(glm::vec2(X[i], Y[i]), glm::vec2(0.0f), Direction);
+		Sink = Direction.x;
+	}));
+
+	// One easing tick over many entities, each with its own target. The old
+	// angles still needed a cos and sin per sprite before drawing.
+	std::vector<float> Theta(Samples, 0.0f), TargetTheta(Samples), Cos(Samples), Sin(Samples);
+	std::vector<float> RotationC(Samples, 1.0f), RotationS(Samples, 0.0f), DirectionX(Samples), DirectionY(Samples);
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		glm::vec3 Direction(0.0f, 1.0f, 0.0f);
+		TargetTheta[i] = legacy_find_rotation_theta(glm::vec2(X[i], Y[i]), glm::vec2(0.0f), Direction, 0.0f);
+		DirectionX[i] = Direction.x;
+		DirectionY[i] = Direction.y;
+	}
+
+	std::printf("theta easing + trig:  %8.2f ns/op (old)\n", launch_ns_per_op(Samples, [&]()
+	{
+		for(std::size_t i = 0; i < Samples; ++i)
+		{
+			if(std::abs(Theta[i] - TargetTheta[i]) >= 0.005f)
+				Theta[i] += Theta[i] < TargetTheta[i] ? 0.05f : -0.05f;
+			else
+				Theta[i] = TargetTheta[i];
+			Cos[i] = std::cos(Theta[i]);
+			Sin[i] = std::sin(Theta[i]);
+		}
+		Sink = Cos[Samples / 2];
+	}));
+
+	std::printf("turnTowards:          %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		turnTowards(RotationC.data(), RotationS.data(), DirectionY.data(), DirectionX.data(), Samples, glm::vec2(0.99875026f, 0.04997917f));
+		Sink = RotationC[Samples / 2];
+	}));
+
+	// Turned all the way round, both end up facing where the click was. The
+	// old angles are only close: acos loses precision near 0 and pi.
+	for(int Tick = 0; Tick < 200; ++Tick)
+		turnTowards(RotationC.data(), RotationS.data(), DirectionY.data(), DirectionX.data(), Samples, glm::vec2(0.99875026f, 0.04997917f));
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		glm::vec2 Facing = rotationFacing(glm::vec2(DirectionX[i], DirectionY[i]));
+		Error += (RotationC[i] == Facing.x && RotationS[i] == Facing.y) ? 0 : 1;
+		Error += std::abs(std::cos(TargetTheta[i]) - Facing.x) < 1e-3f ? 0 : 1;
+		Error += std::abs(std::sin(TargetTheta[i]) - Facing.y) < 1e-3f ? 0 : 1;
+	}
+
+	// Turning a long way without ever snapping (the target is always half a
+	// turn away) keeps the length at 1
+	glm::vec2 Rotation(1.0f, 0.0f);
+	for(int Tick = 0; Tick < 100000; ++Tick)
+		Rotation = turnToward(Rotation, -Rotation, glm::vec2(0.99875026f, 0.04997917f));
+	Error += std::abs(glm::length(Rotation) - 1.0f) < 1e-6f ? 0 : 1;
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	std::size_t const Samples = 1000000;
+
+	Error += perf_sin_cos(Samples, 6.2831853f);
+	Error += perf_sin_cos(Samples, 8192.0f);
+	Error += perf_atan2(Samples);
+	Error += perf_rotation(Samples);
+
+	return Error;
+}
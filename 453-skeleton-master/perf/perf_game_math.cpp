@@ -0,0 +1,179 @@
+#include "GameMath.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Keeps results alive so the compiler can't optimize the measured work away
+static volatile float Sink = 0.0f;
+
+// Runs f a few times and returns the fastest run in nanoseconds per operation
+template <typename F>
+static double launch_ns_per_op(std::size_t Samples, F&& f)
+{
+	double Best = 1e30;
+	for(int Run = 0; Run < 5; ++Run)
+	{
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		f();
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
+		Best = std::min(Best, ns / static_cast<double>(Samples));
+	}
+	return Best;
+}
+
+// Input distributions for the distance checks, relative to a ship at the origin
+enum distribution
+{
+	UNIFORM,	// anywhere on screen, a few percent within orbit
+	CLUSTERED,	// crowded around the ship, most within orbit
+	FAR			// never within orbit
+};
+
+static char const* distribution_name(distribution D)
+{
+	switch(D)
+	{
+	case UNIFORM: return "uniform";
+	case CLUSTERED: return "clustered";
+	case FAR: return "far";
+	}
+	return "";
+}
+
+static void make_points(distribution D, std::size_t Samples, std::vector<float>& X, std::vector<float>& Y)
+{
+	std::mt19937 Rng(453);
+	std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> Near(-0.3f, 0.3f);
+	std::uniform_real_distribution<float> Angle(0.0f, 6.2831853f);
+	std::uniform_real_distribution<float> Distance(0.5f, 1.5f);
+
+	X.resize(Samples);
+	Y.resize(Samples);
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		switch(D)
+		{
+		case UNIFORM:
+			X[i] = Unit(Rng);
+			Y[i] = Unit(Rng);
+			break;
+		case CLUSTERED:
+			X[i] = Near(Rng);
+			Y[i] = Near(Rng);
+			break;
+		case FAR:
+		{
+			float a = Angle(Rng);
+			float d = Distance(Rng);
+			X[i] = d * std::cos(a);
+			Y[i] = d * std::sin(a);
+			break;
+		}
+		}
+	}
+}
+
+static int perf_unit_vector(std::size_t Samples)
+{
+	int Error = 0;
+
+	std::vector<float> X, Y;
+	make_points(UNIFORM, Samples, X, Y);
+
+	std::vector<glm::vec3> SISD(Samples);
+	std::printf("makeUnitVector:       %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		for(std::size_t i = 0; i < Samples; ++i)
+			SISD[i] = makeUnitVector(glm::vec3(X[i], Y[i], 0.0f));
+	}));
+
+	std::vector<float> BX, BY;
+	std::printf("makeUnitVectors:      %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		BX = X;
+		BY = Y;
+		makeUnitVectors(BX.data(), BY.data(), Samples);
+	}));
+
+	for(std::size_t i = 0; i < Samples; ++i)
+		Error += std::abs(SISD[i].x - BX[i]) < 1e-5f && std::abs(SISD[i].y - BY[i]) < 1e-5f ? 0 : 1;
+
+	return Error;
+}
+
+static int perf_distance(distribution D, std::size_t Samples)
+{
+	int Error = 0;
+
+	std::vector<float> X, Y;
+	make_points(D, Samples, X, Y);
+	glm::vec2 const Ship(0.0f);
+
+	std::printf("-- %s\n", distribution_name(D));
+
+	std::vector<float> SISD(Samples);
+	std::printf("distanceBetween:      %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		for(std::size_t i = 0; i < Samples; ++i)
+			SISD[i] = distanceBetween(Ship, glm::vec2(X[i], Y[i]));
+	}));
+
+	std::vector<float> Batch(Samples);
+	std::printf("distancesBetween:     %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		distancesBetween(Ship, X.data(), Y.data(), Batch.data(), Samples);
+	}));
+
+	std::vector<uint8_t> Hits(Samples);
+	std::size_t ScalarHits = 0;
+	std::printf("withinOrbit:          %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		ScalarHits = 0;
+		for(std::size_t i = 0; i < Samples; ++i)
+		{
+			Hits[i] = withinOrbit(Ship, glm::vec2(X[i], Y[i]));
+			ScalarHits += Hits[i];
+		}
+	}));
+
+	std::vector<uint8_t> BatchHits(Samples);
+	std::size_t BatchCount = 0;
+	double BatchTime = launch_ns_per_op(Samples, [&]()
+	{
+		BatchCount = withinOrbits(Ship, X.data(), Y.data(), BatchHits.data(), Samples);
+	});
+	std::printf("withinOrbits:         %8.2f ns/op (%zu hits)\n", BatchTime, BatchCount);
+
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		Error += std::abs(SISD[i] - Batch[i]) < 1e-6f ? 0 : 1;
+		// sqrt and squared comparisons may disagree right on the boundary
+		if(Hits[i] != BatchHits[i] && std::abs(SISD[i] - ORBIT_RADIUS) > 1e-6f)
+			++Error;
+	}
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	std::size_t const Samples = 1000000;
+
+	Error += perf_unit_vector(Samples);
+	Error += perf_distance(UNIFORM, Samples);
+	Error += perf_distance(CLUSTERED, Samples);
+	Error += perf_distance(FAR, Samples);
+
+	return Error;
+}
@@ -0,0 +1,113 @@
+#include "GameMath.h"
+#include "OrbitKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// The orbit test reads 8 bytes per point and does a handful of flops on them,
+// so once the points no longer fit in cache it should run about as fast as
+// simply reading x and y. Each variant is reported in GB/s of positions read
+// next to a plain streaming read of the same number of bytes.
+
+typedef std::size_t (*orbit_hit_mask)(glm::vec2, float, float const*, float const*, std::size_t, uint64_t*);
+
+static double to_gb_per_second(std::size_t Bytes, std::size_t Repeats, double Seconds)
+{
+	return static_cast<double>(Bytes) * static_cast<double>(Repeats) / Seconds / 1e9;
+}
+
+static double launch_stream_read(std::vector<uint32_t> const& A, std::vector<uint32_t> const& B, std::size_t Repeats, uint32_t& Sink)
+{
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	for(std::size_t r = 0; r < Repeats; ++r)
+	{
+		uint32_t Acc = 0;
+		for(std::size_t i = 0; i < A.size(); ++i)
+			Acc ^= A[i] ^ B[i];
+		Sink ^= Acc;
+	}
+
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(t2 - t1).count();
+}
+
+static double launch_orbit(orbit_hit_mask Function, std::vector<float> const& X, std::vector<float> const& Y, std::vector<uint64_t>& Hits, std::size_t Repeats, std::size_t& Count)
+{
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	for(std::size_t r = 0; r < Repeats; ++r)
+		Count = Function(glm::vec2(0.1f, -0.2f), ORBIT_RADIUS, X.data(), Y.data(), X.size(), Hits.data());
+
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(t2 - t1).count();
+}
+
+static int comp_orbit_kernel(char const* Label, std::size_t Points, std::size_t Repeats)
+{
+	std::mt19937 Rng(1);
+	std::uniform_real_distribution<float> Coord(-1.0f, 1.0f);
+
+	std::vector<float> X(Points), Y(Points);
+	std::vector<uint32_t> A(Points), B(Points);
+	for(std::size_t i = 0; i < Points; ++i)
+	{
+		X[i] = Coord(Rng);
+		Y[i] = Coord(Rng);
+		A[i] = static_cast<uint32_t>(Rng());
+		B[i] = static_cast<uint32_t>(Rng());
+	}
+
+	std::size_t const Bytes = Points * 2 * sizeof(float);
+	std::printf("%s: %zu points, %.1f KiB of positions\n", Label, Points, static_cast<double>(Bytes) / 1024.0);
+
+	uint32_t Sink = 0;
+	double const StreamTime = launch_stream_read(A, B, Repeats, Sink);
+	std::printf("- stream read: %7.2f GB/s (%u)\n", to_gb_per_second(Bytes, Repeats, StreamTime), Sink & 1u);
+
+	orbit_hit_mask const Functions[] = {orbitHitMaskScalar, orbitHitMaskSSE2, orbitHitMaskAVX2};
+	SimdLevel const Levels[] = {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2};
+	SimdLevel const Supported = detectSimdLevel();
+
+	std::vector<uint64_t> Reference(hitMaskWords(Points));
+	std::size_t ReferenceCount = orbitHitMaskScalar(glm::vec2(0.1f, -0.2f), ORBIT_RADIUS, X.data(), Y.data(), Points, Reference.data());
+
+	int Error = 0;
+	for(std::size_t f = 0; f < 3; ++f)
+	{
+		if(static_cast<int>(Levels[f]) > static_cast<int>(Supported))
+		{
+			std::printf("- %-11s  not supported\n", simdLevelName(Levels[f]));
+			continue;
+		}
+
+		std::vector<uint64_t> Hits(hitMaskWords(Points));
+		std::size_t Count = 0;
+		double const Time = launch_orbit(Functions[f], X, Y, Hits, Repeats, Count);
+		std::printf("- %-11s %7.2f GB/s\n", simdLevelName(Levels[f]), to_gb_per_second(Bytes, Repeats, Time));
+
+		Error += (Count == ReferenceCount && Hits == Reference) ? 0 : 1;
+	}
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	std::printf("detected: %s\n", simdLevelName(detectSimdLevel()));
+
+	// Odd sizes also exercise the partial last word
+	Error += comp_orbit_kernel("tail only", 37, 100000);
+	Error += comp_orbit_kernel("in L1", 2048, 100000);
+	Error += comp_orbit_kernel("in L2", 16384, 10000);
+	Error += comp_orbit_kernel("out of cache", 16 * 1024 * 1024 + 5, 20);
+
+	return Error;
+}
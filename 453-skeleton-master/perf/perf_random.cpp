@@ -0,0 +1,161 @@
+#include "JobSystem.h"
+#include "Random.h"
+#include "Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// The old rand() based helpers against Rng, one value at a time and in bulk,
+// and how long spawning a large world takes.
+
+// Keeps results alive so the compiler can't optimize the measured work away
+static volatile float Sink = 0.0f;
+
+// Runs f a few times and returns the fastest run in nanoseconds per operation
+template <typename F>
+static double launch_ns_per_op(std::size_t Samples, F&& f)
+{
+	double Best = 1e30;
+	for(int Run = 0; Run < 5; ++Run)
+	{
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		f();
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
+		Best = std::min(Best, ns / static_cast<double>(Samples));
+	}
+	return Best;
+}
+
+// What makeRandom() and keepWithin() used to do
+static float legacy_make_random()
+{
+	int random = std::rand() % 600;
+	if (random % 2 == 0) random *= -1;
+	return static_cast<float>(random) / 600;
+}
+
+static float legacy_keep_within(float x)
+{
+	float r = legacy_make_random();
+	while(r > x || r < -x)
+		r = legacy_make_random();
+	return r;
+}
+
+static int perf_single(std::size_t Samples)
+{
+	std::srand(453);
+	Rng Random(453);
+
+	std::printf("rand() %% 600:          %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		float Sum = 0.0f;
+		for(std::size_t i = 0; i < Samples; ++i)
+			Sum += legacy_make_random();
+		Sink = Sum;
+	}));
+
+	std::printf("rand() within 0.1:     %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		float Sum = 0.0f;
+		for(std::size_t i = 0; i < Samples; ++i)
+			Sum += legacy_keep_within(0.1f);
+		Sink = Sum;
+	}));
+
+	std::printf("Rng::uniform:          %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		float Sum = 0.0f;
+		for(std::size_t i = 0; i < Samples; ++i)
+			Sum += Random.uniform(-0.1f, 0.1f);
+		Sink = Sum;
+	}));
+
+	std::printf("Rng::below:            %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		uint32_t Sum = 0;
+		for(std::size_t i = 0; i < Samples; ++i)
+			Sum += Random.below(600);
+		Sink = static_cast<float>(Sum);
+	}));
+
+	return 0;
+}
+
+static int perf_bulk(std::size_t Samples)
+{
+	int Error = 0;
+
+	Rng Random(453);
+	std::vector<float> Out(Samples);
+
+	std::printf("Rng::fillUniform:      %8.2f ns/op\n", launch_ns_per_op(Samples, [&]()
+	{
+		Random.fillUniform(Out.data(), Out.size(), -0.5f, 0.5f);
+		Sink = Out[Samples / 2];
+	}));
+
+	// Everything in range, and roughly uniform
+	std::size_t Buckets[10] = {};
+	for(float v : Out)
+	{
+		Error += (v >= -0.5f && v < 0.5f) ? 0 : 1;
+		Buckets[std::min<std::size_t>(9, static_cast<std::size_t>((v + 0.5f) * 10.0f))]++;
+	}
+	for(std::size_t b : Buckets)
+		Error += (b > Samples / 10 * 98 / 100 && b < Samples / 10 * 102 / 100) ? 0 : 1;
+
+	// Same seed, same numbers
+	Rng A(7, 1), B(7, 1);
+	std::vector<float> OutA(1001), OutB(1001);
+	A.fillUniform(OutA.data(), OutA.size(), 0.0f, 1.0f);
+	B.fillUniform(OutB.data(), OutB.size(), 0.0f, 1.0f);
+	Error += OutA == OutB ? 0 : 1;
+
+	return Error;
+}
+
+static int perf_spawn(int Diamonds)
+{
+	JobSystem Jobs(1);
+
+	// Fastest of a few runs, as launch_ns_per_op does. A fresh spawn pays
+	// for faulting in new memory, a respawn reuses what it already has.
+	double Spawn = 1e30;
+	double Respawn = 1e30;
+	std::size_t Size = 0;
+	for(int Run = 0; Run < 5; ++Run)
+	{
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		Simulation World(Jobs, Diamonds, 453);
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		World.reset();
+		std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
+
+		Spawn = std::min(Spawn, std::chrono::duration<double, std::milli>(t2 - t1).count());
+		Respawn = std::min(Respawn, std::chrono::duration<double, std::milli>(t3 - t2).count());
+		Size = World.getEntities().size();
+	}
+
+	std::printf("spawn %7d diamonds: %8.2f ms (respawn %.2f ms)\n", Diamonds, Spawn, Respawn);
+	return Size == static_cast<std::size_t>(Diamonds) + 1 ? 0 : 1;
+}
+
+int main()
+{
+	int Error = 0;
+
+	std::size_t const Samples = 1000000;
+
+	Error += perf_single(Samples);
+	Error += perf_bulk(Samples);
+	Error += perf_spawn(4);
+	Error += perf_spawn(1000000);
+
+	return Error;
+}